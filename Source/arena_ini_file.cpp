@@ -0,0 +1,184 @@
+#include "arena_ini_file.h"
+
+#include <cstring>
+#include <utility>
+
+namespace tom {
+
+arena_ini_file::arena_ini_file(std::string name_, std::size_t initial_capacity) :
+    arena(std::make_unique<std::pmr::monotonic_buffer_resource>(initial_capacity)),
+    section_records(arena.get()),
+    entry_records(arena.get()),
+    section_index(arena.get()),
+    entry_index(arena.get()),
+    name(std::move(name_)) { }
+
+std::string_view arena_ini_file::copy_into_arena(std::string_view text) {
+    if (text.empty())
+        return std::string_view{ };
+    auto* storage = static_cast<char*>(arena->allocate(text.size(), 1));
+    std::memcpy(storage, text.data(), text.size());
+    return std::string_view{storage, text.size()};
+}
+
+void arena_ini_file::move_entries_to_end(section_record& section) {
+    if (section.first_entry + section.entry_count == entry_records.size())
+        return;
+
+    // removed entries are left behind rather than copied
+    auto const    first = static_cast<std::uint32_t>(entry_records.size());
+    std::uint32_t live  = 0;
+    for (std::uint32_t i = 0; i < section.entry_count; i++) {
+        // a copy, push_back below may reallocate
+        entry_record const old = entry_records[section.first_entry + i];
+        if (!old.alive)
+            continue;
+        entry_records[section.first_entry + i].alive = false;
+        entry_index[entry_slot{old.section, old.key}] = static_cast<std::uint32_t>(entry_records.size());
+        entry_records.push_back(old);
+        live++;
+    }
+    section.first_entry = first;
+    section.entry_count = live;
+}
+
+arena_ini_file::section_handle arena_ini_file::put_section(std::string_view section_name) {
+    auto const index = static_cast<std::uint32_t>(section_records.size());
+    section_records.push_back(section_record{section_name, static_cast<std::uint32_t>(entry_records.size()), 0, true});
+
+    auto [it, inserted] = section_index.try_emplace(section_name, index);
+    if (!inserted) {
+        remove_section(section_name);
+        // remove_section dropped the index entry for the old section
+        section_index.emplace(section_name, index);
+    }
+    return section_handle{index};
+}
+
+arena_ini_file::section_handle arena_ini_file::add_section(std::string_view section_name) {
+    return put_section(copy_into_arena(section_name));
+}
+
+arena_ini_file::section_handle arena_ini_file::add_section_borrowed(std::string_view section_name) {
+    return put_section(section_name);
+}
+
+void arena_ini_file::remove_section(std::string_view section_name) {
+    auto it = section_index.find(section_name);
+    if (it == section_index.end())
+        return;
+
+    section_record& section = section_records[it->second];
+    for (std::uint32_t i = 0; i < section.entry_count; i++) {
+        entry_record& entry = entry_records[section.first_entry + i];
+        if (entry.alive) {
+            entry_index.erase(entry_slot{entry.section, entry.key});
+            entry.alive = false;
+        }
+    }
+    section.alive = false;
+    section_index.erase(it);
+}
+
+arena_ini_file::section_handle arena_ini_file::get_section(std::string_view section_name) const {
+    auto it = section_index.find(section_name);
+    return it == section_index.end() ? section_handle{ } : section_handle{it->second};
+}
+
+bool arena_ini_file::put_entry(section_handle handle, std::string_view key, std::string_view value) {
+    if (auto it = entry_index.find(entry_slot{handle.index, key}); it != entry_index.end()) {
+        entry_records[it->second].value = value;
+        return true;
+    }
+
+    section_record& section = section_records[handle.index];
+    move_entries_to_end(section);
+
+    entry_index.emplace(entry_slot{handle.index, key}, static_cast<std::uint32_t>(entry_records.size()));
+    entry_records.push_back(entry_record{key, value, handle.index, true});
+    section.entry_count++;
+    return false;
+}
+
+bool arena_ini_file::add_entry(section_handle section, std::string_view key, std::string_view value) {
+    // only copy the key if it is new, replacing keeps the existing one
+    if (auto it = entry_index.find(entry_slot{section.index, key}); it != entry_index.end()) {
+        entry_records[it->second].value = copy_into_arena(value);
+        return true;
+    }
+    return put_entry(section, copy_into_arena(key), copy_into_arena(value));
+}
+
+bool arena_ini_file::add_entry_borrowed(section_handle section, std::string_view key, std::string_view value) {
+    return put_entry(section, key, value);
+}
+
+bool arena_ini_file::remove_entry(section_handle section, std::string_view key) {
+    auto it = entry_index.find(entry_slot{section.index, key});
+    if (it == entry_index.end())
+        return false;
+    entry_records[it->second].alive = false;
+    entry_index.erase(it);
+    return true;
+}
+
+arena_ini_file::entry_handle arena_ini_file::get_entry(section_handle section, std::string_view key) const {
+    auto it = entry_index.find(entry_slot{section.index, key});
+    return it == entry_index.end() ? entry_handle{ } : entry_handle{it->second};
+}
+
+arena_ini_file::entry_handle arena_ini_file::get_entry(std::string_view key) const {
+    for (auto section : sections())
+        if (auto entry = get_entry(section, key))
+            return entry;
+    return entry_handle{ };
+}
+
+std::string_view arena_ini_file::section_name(section_handle section) const {
+    return section_records[section.index].name;
+}
+
+std::string_view arena_ini_file::key(entry_handle entry) const {
+    return entry_records[entry.index].key;
+}
+
+std::string_view arena_ini_file::value(entry_handle entry) const {
+    return entry_records[entry.index].value;
+}
+
+arena_ini_file::section_handle arena_ini_file::section_of(entry_handle entry) const {
+    return section_handle{entry_records[entry.index].section};
+}
+
+arena_ini_file::section_range arena_ini_file::sections() const {
+    return section_range{this};
+}
+
+arena_ini_file::entry_range arena_ini_file::entries(section_handle section) const {
+    auto const& record = section_records[section.index];
+    return entry_range{this, record.first_entry, record.first_entry + record.entry_count};
+}
+
+std::size_t arena_ini_file::section_count() const noexcept {
+    return section_index.size();
+}
+
+std::size_t arena_ini_file::entry_count() const noexcept {
+    return entry_index.size();
+}
+
+void arena_ini_file::retain(std::shared_ptr<void const> storage) {
+    retained.push_back(std::move(storage));
+}
+
+std::ostream& operator <<(std::ostream& os, arena_ini_file const& self) {
+    for (auto section : self.sections()) {
+        os << "[" << self.section_name(section) << "]\n";
+        for (auto entry : self.entries(section))
+            os << self.key(entry) << "=" << self.value(entry) << "\n";
+        os << "\n";
+    }
+    return os;
+}
+
+}  // namespace tom
@@ -0,0 +1,250 @@
+#ifndef PARSEINI_ARENA_INI_FILE_H
+#define PARSEINI_ARENA_INI_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tom {
+
+// an alternative to ini_file that keeps every section and entry in flat arrays
+// allocated from one monotonic arena. There are no per node allocations and no
+// reference counting: sections and entries are named by small handles that
+// index the arrays, and the whole arena is released at once when the file is
+// destroyed.
+//
+// A section's entries are stored next to each other. Adding an entry to a
+// section that is not the last one moves that section's entries to the end.
+// Removing an entry or replacing a section leaves its old slots unused until
+// the file is destroyed
+class arena_ini_file {
+public:
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    struct section_handle {
+        std::uint32_t index = npos;
+
+        explicit operator bool() const noexcept { return index != npos; }
+
+        bool operator ==(section_handle rhs) const noexcept { return index == rhs.index; }
+
+        bool operator !=(section_handle rhs) const noexcept { return index != rhs.index; }
+    };
+
+    struct entry_handle {
+        std::uint32_t index = npos;
+
+        explicit operator bool() const noexcept { return index != npos; }
+
+        bool operator ==(entry_handle rhs) const noexcept { return index == rhs.index; }
+
+        bool operator !=(entry_handle rhs) const noexcept { return index != rhs.index; }
+    };
+
+private:
+    struct section_record {
+        std::string_view name;
+        std::uint32_t    first_entry = 0;
+        std::uint32_t    entry_count = 0;
+        bool             alive       = true;
+    };
+
+    struct entry_record {
+        std::string_view key;
+        std::string_view value;
+        std::uint32_t    section = npos;
+        bool             alive   = true;
+    };
+
+    struct entry_slot {
+        std::uint32_t    section;
+        std::string_view key;
+
+        bool operator ==(entry_slot const& rhs) const noexcept {
+            return section == rhs.section && key == rhs.key;
+        }
+    };
+
+    struct entry_slot_hash {
+        std::size_t operator ()(entry_slot const& slot) const noexcept {
+            return std::hash<std::string_view>{ }(slot.key) ^ (std::size_t{slot.section} * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    // heap allocated so the file can move without the containers below losing
+    // the resource they allocate from
+    std::unique_ptr<std::pmr::monotonic_buffer_resource>                              arena;
+    std::pmr::vector<section_record>                                                  section_records;
+    std::pmr::vector<entry_record>                                                    entry_records;
+    std::pmr::unordered_map<std::string_view, std::uint32_t>                          section_index;
+    std::pmr::unordered_map<entry_slot, std::uint32_t, entry_slot_hash>               entry_index;
+    std::vector<std::shared_ptr<void const>>                                          retained;
+
+    std::string_view copy_into_arena(std::string_view text);
+
+    // makes sure section is the last one in entry_records so it can grow in place
+    void move_entries_to_end(section_record& section);
+
+public:
+    std::string const name;
+
+    // iterates the live entries of one section
+    class entry_range {
+        arena_ini_file const* file;
+        std::uint32_t         first;
+        std::uint32_t         last;
+
+    public:
+        class iterator {
+            arena_ini_file const* file;
+            std::uint32_t         index;
+            std::uint32_t         last;
+
+            void skip_dead() {
+                while (index != last && !file->entry_records[index].alive)
+                    index++;
+            }
+
+        public:
+            iterator(arena_ini_file const* file, std::uint32_t index, std::uint32_t last) :
+                file(file), index(index), last(last) { skip_dead(); }
+
+            entry_handle operator *() const noexcept { return entry_handle{index}; }
+
+            iterator& operator ++() {
+                index++;
+                skip_dead();
+                return *this;
+            }
+
+            bool operator ==(iterator const& rhs) const noexcept { return index == rhs.index; }
+
+            bool operator !=(iterator const& rhs) const noexcept { return index != rhs.index; }
+        };
+
+        entry_range(arena_ini_file const* file, std::uint32_t first, std::uint32_t last) :
+            file(file), first(first), last(last) { }
+
+        [[nodiscard]] iterator begin() const { return iterator{file, first, last}; }
+
+        [[nodiscard]] iterator end() const { return iterator{file, last, last}; }
+    };
+
+    // iterates the live sections of the file in the order they were added
+    class section_range {
+        arena_ini_file const* file;
+
+    public:
+        class iterator {
+            arena_ini_file const* file;
+            std::uint32_t         index;
+
+            void skip_dead() {
+                while (index != file->section_records.size() && !file->section_records[index].alive)
+                    index++;
+            }
+
+        public:
+            iterator(arena_ini_file const* file, std::uint32_t index) : file(file), index(index) { skip_dead(); }
+
+            section_handle operator *() const noexcept { return section_handle{index}; }
+
+            iterator& operator ++() {
+                index++;
+                skip_dead();
+                return *this;
+            }
+
+            bool operator ==(iterator const& rhs) const noexcept { return index == rhs.index; }
+
+            bool operator !=(iterator const& rhs) const noexcept { return index != rhs.index; }
+        };
+
+        explicit section_range(arena_ini_file const* file) : file(file) { }
+
+        [[nodiscard]] iterator begin() const { return iterator{file, 0}; }
+
+        [[nodiscard]] iterator end() const {
+            return iterator{file, static_cast<std::uint32_t>(file->section_records.size())};
+        }
+    };
+
+    arena_ini_file() = delete;
+
+    // initial_capacity is the size of the first arena block, a good guess is
+    // about twice the size of the file being parsed
+    explicit arena_ini_file(std::string name_, std::size_t initial_capacity = 64 * 1024);
+
+    arena_ini_file(arena_ini_file const&) = delete;
+
+    arena_ini_file(arena_ini_file&&) noexcept = default;
+
+    arena_ini_file& operator =(arena_ini_file const&) = delete;
+
+    // the containers would keep memory from the arena being replaced
+    arena_ini_file& operator =(arena_ini_file&&) = delete;
+
+    // adds an empty section. A section of the same name is replaced, as with
+    // ini_file::add_section. The name is copied into the arena
+    section_handle add_section(std::string_view section_name);
+
+    // as above but the name is only viewed, its storage must be retained
+    section_handle add_section_borrowed(std::string_view section_name);
+
+    void remove_section(std::string_view section_name);
+
+    [[nodiscard]] section_handle get_section(std::string_view section_name) const;
+
+    // adds or replaces the entry key in section. Returns true if it replaced one.
+    // Key and value are copied into the arena
+    bool add_entry(section_handle section, std::string_view key, std::string_view value);
+
+    // as above but key and value are only viewed, their storage must be retained
+    bool add_entry_borrowed(section_handle section, std::string_view key, std::string_view value);
+
+    bool remove_entry(section_handle section, std::string_view key);
+
+    [[nodiscard]] entry_handle get_entry(section_handle section, std::string_view key) const;
+
+    // the entry in the first section (in the order they were added) defining key
+    [[nodiscard]] entry_handle get_entry(std::string_view key) const;
+
+    [[nodiscard]] std::string_view section_name(section_handle section) const;
+
+    [[nodiscard]] std::string_view key(entry_handle entry) const;
+
+    [[nodiscard]] std::string_view value(entry_handle entry) const;
+
+    [[nodiscard]] section_handle section_of(entry_handle entry) const;
+
+    [[nodiscard]] section_range sections() const;
+
+    [[nodiscard]] entry_range entries(section_handle section) const;
+
+    [[nodiscard]] std::size_t section_count() const noexcept;
+
+    [[nodiscard]] std::size_t entry_count() const noexcept;
+
+    // keeps storage alive for as long as this file, see ini_file::retain
+    void retain(std::shared_ptr<void const> storage);
+
+    friend std::ostream& operator <<(std::ostream&, arena_ini_file const&);
+
+    ~arena_ini_file() = default;
+
+private:
+    bool put_entry(section_handle section, std::string_view key, std::string_view value);
+
+    section_handle put_section(std::string_view section_name);
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_ARENA_INI_FILE_H
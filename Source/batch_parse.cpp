@@ -0,0 +1,51 @@
+#include "batch_parse.h"
+
+#include <atomic>
+
+namespace tom {
+
+namespace {
+
+void parse_one(batch_result& result, batch_options const& options, std::shared_ptr<string_pool> const& pool) {
+    try {
+        // a file that cannot be opened throws std::system_error
+        ini_parser parser{result.filename, options.comment_chars, options.line_separator, options.mode};
+        parser.use_string_pool(pool);
+        result.file.emplace(parser.parse());
+    } catch (parse_error const& e) {
+        // parse_error does not publicly derive from std::exception
+        result.error         = std::current_exception();
+        result.error_message = e.what();
+    } catch (std::exception const& e) {
+        result.error         = std::current_exception();
+        result.error_message = e.what();
+    } catch (...) {
+        result.error         = std::current_exception();
+        result.error_message = "Unknown error";
+    }
+}
+
+}  // namespace
+
+std::vector<batch_result> parse_many(std::vector<std::string> const& paths, batch_options const& options) {
+    std::vector<batch_result> results(paths.size());
+    if (paths.empty())
+        return results;
+
+    auto const   pool    = options.pool != nullptr ? options.pool : std::make_shared<string_pool>();
+    thread_pool& workers = options.workers != nullptr ? *options.workers : thread_pool::shared();
+
+    std::atomic<std::size_t> remaining{paths.size()};
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        results[i].filename = paths[i];
+        workers.submit([&results, &options, &pool, &remaining, i] {
+            parse_one(results[i], options, pool);
+            remaining--;
+        });
+    }
+    workers.run_until([&remaining] { return remaining == 0; });
+
+    return results;
+}
+
+}  // namespace tom
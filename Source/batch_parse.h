@@ -0,0 +1,45 @@
+#ifndef PARSEINI_BATCH_PARSE_H
+#define PARSEINI_BATCH_PARSE_H
+
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "ini_file.h"
+#include "ini_parser.h"
+#include "string_pool.h"
+#include "thread_pool.h"
+
+namespace tom {
+
+struct batch_options {
+    std::vector<char> comment_chars  = {'#', ';'};
+    char              line_separator = '\n';
+    input_mode        mode           = input_mode::buffered;
+
+    // keys from every file of the batch are stored here once. The batch gets
+    // a pool of its own when this is nullptr
+    std::shared_ptr<string_pool> pool = nullptr;
+
+    // runs the parses, thread_pool::shared() when this is nullptr
+    thread_pool* workers = nullptr;
+};
+
+// the outcome of parsing one file of a batch, either file or error is set
+struct batch_result {
+    std::string             filename;
+    std::optional<ini_file> file{ };
+    std::exception_ptr      error{ };
+    std::string             error_message{ };
+
+    explicit operator bool() const noexcept { return file.has_value(); }
+};
+
+// parses every file in paths as a task on a work stealing thread pool. One
+// file failing does not affect the others. Results are in the order of paths
+std::vector<batch_result> parse_many(std::vector<std::string> const& paths, batch_options const& options = {});
+
+}  // namespace tom
+
+#endif  // PARSEINI_BATCH_PARSE_H
@@ -0,0 +1,172 @@
+#include "char_scanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PARSEINI_X86 1
+#include <immintrin.h>
+#endif
+
+namespace tom {
+
+namespace {
+
+inline bool is_c_space(char c) noexcept {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+std::size_t find_scalar(char_scanner const& self, char const* first, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++)
+        if (self.is_stop(first[i]))
+            return i;
+    return n;
+}
+
+std::size_t skip_space_scalar(char_scanner const&, char const* first, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++)
+        if (!is_c_space(first[i]))
+            return i;
+    return n;
+}
+
+#ifdef PARSEINI_X86
+
+// the vector kernels need the stop chars themselves, not just the table
+struct stop_list {
+    char const* chars;
+    std::size_t count;
+};
+
+inline __m128i matches_sse2(__m128i block, stop_list stops) {
+    __m128i hit = _mm_setzero_si128();
+    for (std::size_t k = 0; k < stops.count; k++)
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, _mm_set1_epi8(stops.chars[k])));
+    return hit;
+}
+
+// a byte is a space if it is ' ' or, after subtracting '\t', at most '\r' - '\t'
+inline __m128i spaces_sse2(__m128i block) {
+    __m128i const shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+    __m128i const ranged  = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+    return _mm_or_si128(ranged, _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+}
+
+std::size_t find_sse2_impl(char_scanner const& self, stop_list stops, char const* first, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first + i));
+        if (int mask = _mm_movemask_epi8(matches_sse2(block, stops)); mask != 0)
+            return i + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    return i + find_scalar(self, first + i, n - i);
+}
+
+std::size_t skip_space_sse2(char_scanner const& self, char const* first, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first + i));
+        if (int mask = ~_mm_movemask_epi8(spaces_sse2(block)) & 0xFFFF; mask != 0)
+            return i + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    return i + skip_space_scalar(self, first + i, n - i);
+}
+
+__attribute__((target("avx2")))
+std::size_t find_avx2_impl(char_scanner const& self, stop_list stops, char const* first, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i const block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first + i));
+        __m256i       hit   = _mm256_setzero_si256();
+        for (std::size_t k = 0; k < stops.count; k++)
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(stops.chars[k])));
+        if (auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hit)); mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return i + find_sse2_impl(self, stops, first + i, n - i);
+}
+
+__attribute__((target("avx2")))
+std::size_t skip_space_avx2(char_scanner const& self, char const* first, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i const block   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first + i));
+        __m256i const shifted = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+        __m256i const ranged  = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+        __m256i const spaces  = _mm256_or_si256(ranged, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')));
+        if (auto mask = ~static_cast<unsigned>(_mm256_movemask_epi8(spaces)); mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return i + skip_space_sse2(self, first + i, n - i);
+}
+
+#endif  // PARSEINI_X86
+
+}  // namespace
+
+// the vector kernels are members only so they can see the stop chars
+struct char_scanner_kernels {
+#ifdef PARSEINI_X86
+    static std::size_t find_sse2(char_scanner const& self, char const* first, std::size_t n) {
+        return find_sse2_impl(self, stop_list{self.stops.data(), self.stop_count}, first, n);
+    }
+
+    static std::size_t find_avx2(char_scanner const& self, char const* first, std::size_t n) {
+        return find_avx2_impl(self, stop_list{self.stops.data(), self.stop_count}, first, n);
+    }
+#endif
+};
+
+char_scanner::kernel char_scanner::best_kernel() noexcept {
+#ifdef PARSEINI_X86
+    static kernel const best = __builtin_cpu_supports("avx2") ? kernel::avx2 : kernel::sse2;
+    return best;
+#else
+    return kernel::scalar;
+#endif
+}
+
+char_scanner::char_scanner(std::string_view stop_chars, kernel k) {
+    for (char c : stop_chars) {
+        if (table[static_cast<unsigned char>(c)])
+            continue;
+        table[static_cast<unsigned char>(c)] = true;
+        if (stop_count < max_vector_stops)
+            stops[stop_count] = c;
+        stop_count++;
+    }
+
+    if (k == kernel::best)
+        k = best_kernel();
+
+#ifdef PARSEINI_X86
+    // asking for a kernel the cpu cannot run gets the best one it can
+    if (k == kernel::avx2 && best_kernel() != kernel::avx2)
+        k = kernel::sse2;
+#else
+    k = kernel::scalar;
+#endif
+
+    // too many stops and comparing against each would be slower than the table,
+    // so the whole scanner runs scalar and says so
+    if (stop_count > max_vector_stops)
+        k = kernel::scalar;
+
+    kernel_ = k;
+    switch (k) {
+#ifdef PARSEINI_X86
+        case kernel::avx2:
+            find_       = &char_scanner_kernels::find_avx2;
+            skip_space_ = &skip_space_avx2;
+            break;
+        case kernel::sse2:
+            find_       = &char_scanner_kernels::find_sse2;
+            skip_space_ = &skip_space_sse2;
+            break;
+#endif
+        default:
+            kernel_     = kernel::scalar;
+            find_       = &find_scalar;
+            skip_space_ = &skip_space_scalar;
+            break;
+    }
+}
+
+}  // namespace tom
@@ -0,0 +1,68 @@
+#ifndef PARSEINI_CHAR_SCANNER_H
+#define PARSEINI_CHAR_SCANNER_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace tom {
+
+// finds the first occurrence of any of a small set of stop chars in a block of
+// memory. The search runs 16 (SSE2) or 32 (AVX2) bytes at a time when the cpu
+// supports it, which is picked once at runtime, and falls back to a table
+// lookup per byte otherwise
+class char_scanner {
+public:
+    enum class kernel {
+        scalar,
+        sse2,
+        avx2,
+        // the widest kernel the running cpu supports
+        best
+    };
+
+    // sets of more stop chars than this always get the scalar kernel
+    static constexpr std::size_t max_vector_stops = 8;
+
+    using find_fn = std::size_t (*)(char_scanner const&, char const*, std::size_t);
+
+private:
+    std::array<bool, 256>              table{ };
+    std::array<char, max_vector_stops> stops{ };
+    std::size_t                        stop_count = 0;
+    kernel                             kernel_;
+    find_fn                            find_;
+    find_fn                            skip_space_;
+
+    friend struct char_scanner_kernels;
+
+public:
+    explicit char_scanner(std::string_view stop_chars = { }, kernel k = kernel::best);
+
+    // index of the first stop char in [first, first + n) or n if there is none
+    [[nodiscard]] std::size_t find(char const* first, std::size_t n) const {
+        return find_(*this, first, n);
+    }
+
+    // index of the first char in [first, first + n) that is not whitespace in
+    // the "C" locale (space, \t, \n, \v, \f, \r) or n if they all are
+    [[nodiscard]] std::size_t skip_space(char const* first, std::size_t n) const {
+        return skip_space_(*this, first, n);
+    }
+
+    [[nodiscard]] bool is_stop(char c) const noexcept {
+        return table[static_cast<unsigned char>(c)];
+    }
+
+    // the kernel find and skip_space actually run, never kernel::best
+    [[nodiscard]] kernel selected_kernel() const noexcept {
+        return kernel_;
+    }
+
+    // the kernel that kernel::best resolves to on this cpu
+    static kernel best_kernel() noexcept;
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_CHAR_SCANNER_H
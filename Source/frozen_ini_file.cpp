@@ -0,0 +1,162 @@
+#include "frozen_ini_file.h"
+
+#include <unordered_map>
+#include "ini_entry.h"
+#include "ini_file.h"
+#include "ini_section.h"
+
+namespace tom {
+
+frozen_ini_file::frozen_ini_file(ini_file const& file) {
+    std::unordered_map<std::string_view, text_ref> stored{ };
+    auto const store = [this, &stored](std::string_view part) {
+        auto [it, inserted] = stored.try_emplace(part, text_ref{static_cast<std::uint32_t>(text.size()),
+                                                                static_cast<std::uint32_t>(part.size())});
+        if (inserted)
+            text.append(part);
+        return it->second;
+    };
+
+    std::vector<ini_section const*> by_slot{ };
+    {
+        std::vector<ini_section const*> found{ };
+        std::vector<std::uint64_t>      hashes{ };
+        for (auto const& section : file.each_section()) {
+            found.push_back(&section);
+            hashes.push_back(hash(section.name));
+        }
+
+        auto const slots = perfect_hash::build(hashes, section_displacements);
+        by_slot.resize(found.size());
+        for (std::size_t i = 0; i < found.size(); i++)
+            by_slot[slots[i]] = found[i];
+    }
+
+    std::unordered_map<ini_entry const*, std::uint32_t> entry_index{ };
+    std::vector<ini_entry const*>                       found{ };
+    std::vector<std::uint64_t>                          hashes{ };
+
+    for (std::uint32_t index = 0; index < by_slot.size(); index++) {
+        found.clear();
+        hashes.clear();
+        for (auto const& entry : by_slot[index]->each_entry()) {
+            found.push_back(&entry);
+            hashes.push_back(hash(entry.key_view()));
+        }
+
+        auto const first              = static_cast<std::uint32_t>(entries.size());
+        auto const first_displacement = static_cast<std::uint32_t>(key_displacements.size());
+        auto const slots              = perfect_hash::build(hashes, key_displacements);
+
+        sections.push_back(section_record{store(by_slot[index]->name), first,
+                                          static_cast<std::uint32_t>(found.size()), first_displacement});
+        entries.resize(first + found.size());
+        for (std::size_t i = 0; i < found.size(); i++) {
+            entries[first + slots[i]] = entry_record{store(found[i]->key_view()), store(found[i]->value_view()), index};
+            entry_index.emplace(found[i], first + slots[i]);
+        }
+    }
+
+    // one slot per distinct key, pointing at the entry the file's index finds
+    std::vector<std::uint32_t> first_entries{ };
+    std::unordered_map<std::string_view, bool> seen{ };
+    hashes.clear();
+    for (auto const& entry : entries) {
+        auto const key = view(entry.key);
+        if (!seen.emplace(key, true).second)
+            continue;
+        first_entries.push_back(entry_index.at(file.get_entry(key).get()));
+        hashes.push_back(hash(key));
+    }
+
+    auto const slots = perfect_hash::build(hashes, file_key_displacements);
+    file_keys.resize(first_entries.size());
+    for (std::size_t i = 0; i < first_entries.size(); i++)
+        file_keys[slots[i]] = first_entries[i];
+}
+
+frozen_ini_file::section_handle frozen_ini_file::get_section(std::string_view name) const noexcept {
+    auto const count = static_cast<std::uint32_t>(sections.size());
+    if (count == 0)
+        return section_handle{ };
+
+    auto const at = perfect_hash::slot(section_displacements.data(), count, hash(name));
+    return view(sections[at].name) == name ? section_handle{at} : section_handle{ };
+}
+
+frozen_ini_file::entry_handle frozen_ini_file::get_entry(section_handle section, std::string_view key) const noexcept {
+    if (!section || sections[section.index].entry_count == 0)
+        return entry_handle{ };
+
+    auto const& record = sections[section.index];
+    auto const  at     = record.first_entry + perfect_hash::slot(key_displacements.data() + record.first_displacement,
+                                                                 record.entry_count, hash(key));
+    return view(entries[at].key) == key ? entry_handle{at} : entry_handle{ };
+}
+
+frozen_ini_file::entry_handle frozen_ini_file::get_entry(std::string_view key) const noexcept {
+    auto const count = static_cast<std::uint32_t>(file_keys.size());
+    if (count == 0)
+        return entry_handle{ };
+
+    auto const at = file_keys[perfect_hash::slot(file_key_displacements.data(), count, hash(key))];
+    return view(entries[at].key) == key ? entry_handle{at} : entry_handle{ };
+}
+
+std::optional<std::string_view> frozen_ini_file::get_value(
+    std::string_view section, std::string_view key
+) const noexcept {
+    if (auto entry = get_entry(get_section(section), key))
+        return value(entry);
+    return std::nullopt;
+}
+
+std::string_view frozen_ini_file::section_name(section_handle section) const noexcept {
+    return view(sections[section.index].name);
+}
+
+std::string_view frozen_ini_file::key(entry_handle entry) const noexcept {
+    return view(entries[entry.index].key);
+}
+
+std::string_view frozen_ini_file::value(entry_handle entry) const noexcept {
+    return view(entries[entry.index].value);
+}
+
+frozen_ini_file::section_handle frozen_ini_file::section_of(entry_handle entry) const noexcept {
+    return section_handle{entries[entry.index].section};
+}
+
+std::uint32_t frozen_ini_file::section_count() const noexcept {
+    return static_cast<std::uint32_t>(sections.size());
+}
+
+frozen_ini_file::section_handle frozen_ini_file::section_at(std::uint32_t index) const noexcept {
+    return section_handle{index};
+}
+
+std::uint32_t frozen_ini_file::entry_count(section_handle section) const noexcept {
+    return sections[section.index].entry_count;
+}
+
+frozen_ini_file::entry_handle frozen_ini_file::entry_at(section_handle section, std::uint32_t index) const noexcept {
+    return entry_handle{sections[section.index].first_entry + index};
+}
+
+std::uint32_t frozen_ini_file::entry_count() const noexcept {
+    return static_cast<std::uint32_t>(entries.size());
+}
+
+std::ostream& operator <<(std::ostream& os, frozen_ini_file const& self) {
+    for (auto const& section : self.sections) {
+        os << "[" << self.view(section.name) << "]\n";
+        for (std::uint32_t i = 0; i < section.entry_count; i++) {
+            auto const& entry = self.entries[section.first_entry + i];
+            os << self.view(entry.key) << "=" << self.view(entry.value) << "\n";
+        }
+        os << "\n";
+    }
+    return os;
+}
+
+}  // namespace tom
@@ -0,0 +1,123 @@
+#ifndef PARSEINI_FROZEN_INI_FILE_H
+#define PARSEINI_FROZEN_INI_FILE_H
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "perfect_hash.h"
+
+namespace tom {
+
+struct ini_file;
+
+// an immutable copy of an ini_file, see ini_file::freeze. Section names and
+// the keys of every section are looked up through minimal perfect hashes, so
+// a lookup is one hash of the name, two table reads and one comparison. All
+// the text is in one buffer and the entries of a section sit next to each
+// other. Nothing changes after construction, so any number of threads can
+// read it without locking
+class frozen_ini_file {
+public:
+    struct section_handle {
+        static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t index = npos;
+
+        explicit operator bool() const noexcept { return index != npos; }
+    };
+
+    struct entry_handle {
+        static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t index = npos;
+
+        explicit operator bool() const noexcept { return index != npos; }
+    };
+
+private:
+    struct text_ref {
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+
+    // sections and the entries of each section are stored in the slot order
+    // of their perfect hash
+    struct section_record {
+        text_ref      name;
+        std::uint32_t first_entry;
+        std::uint32_t entry_count;
+        // where the section's perfect hash table starts in key_displacements
+        std::uint32_t first_displacement;
+    };
+
+    struct entry_record {
+        text_ref      key;
+        text_ref      value;
+        std::uint32_t section;
+    };
+
+    std::string                 text{ };
+    std::vector<section_record> sections{ };
+    std::vector<entry_record>   entries{ };
+
+    std::vector<std::int32_t> section_displacements{ };
+    std::vector<std::int32_t> key_displacements{ };
+
+    // every distinct key of the file and the entry ini_file::get_entry finds
+    std::vector<std::int32_t>  file_key_displacements{ };
+    std::vector<std::uint32_t> file_keys{ };
+
+    [[nodiscard]] std::string_view view(text_ref ref) const noexcept {
+        return std::string_view{text.data() + ref.offset, ref.size};
+    }
+
+    // never stored, so the faster std::hash does
+    static std::uint64_t hash(std::string_view name) noexcept {
+        return std::hash<std::string_view>{ }(name);
+    }
+
+public:
+    explicit frozen_ini_file(ini_file const& file);
+
+    [[nodiscard]] section_handle get_section(std::string_view name) const noexcept;
+
+    [[nodiscard]] entry_handle get_entry(section_handle section, std::string_view key) const noexcept;
+
+    // the entry ini_file::get_entry(key) finds
+    [[nodiscard]] entry_handle get_entry(std::string_view key) const noexcept;
+
+    [[nodiscard]] std::optional<std::string_view> get_value(
+        std::string_view section, std::string_view key
+    ) const noexcept;
+
+    [[nodiscard]] std::string_view section_name(section_handle section) const noexcept;
+
+    [[nodiscard]] std::string_view key(entry_handle entry) const noexcept;
+
+    [[nodiscard]] std::string_view value(entry_handle entry) const noexcept;
+
+    [[nodiscard]] section_handle section_of(entry_handle entry) const noexcept;
+
+    // sections are numbered 0 to section_count() - 1, the entries of each
+    // section 0 to entry_count(section) - 1
+    [[nodiscard]] std::uint32_t section_count() const noexcept;
+
+    [[nodiscard]] section_handle section_at(std::uint32_t index) const noexcept;
+
+    [[nodiscard]] std::uint32_t entry_count(section_handle section) const noexcept;
+
+    [[nodiscard]] entry_handle entry_at(section_handle section, std::uint32_t index) const noexcept;
+
+    [[nodiscard]] std::uint32_t entry_count() const noexcept;
+
+    friend std::ostream& operator <<(std::ostream& os, frozen_ini_file const& self);
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_FROZEN_INI_FILE_H
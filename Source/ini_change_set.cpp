@@ -0,0 +1,35 @@
+#include "ini_change_set.h"
+
+namespace tom {
+
+bool ini_change_set::empty() const noexcept {
+    return added_sections.empty() && removed_sections.empty() && modified_sections.empty();
+}
+
+void ini_change_set::apply_to(ini_file& file) const {
+    for (auto const& name : removed_sections)
+        file.remove_section(name);
+
+    for (auto const& name : added_sections)
+        file.add_section(name, nullptr);
+
+    // an entry change for a section file does not have (yet) creates it
+    auto const section_of = [&file](std::string const& name) {
+        if (auto section = file.get_section(name))
+            return section;
+        file.add_section(name, nullptr);
+        return file.get_section(name);
+    };
+
+    for (auto const& change : removed_entries)
+        if (auto section = file.get_section(change.section))
+            section->remove_entry(change.key);
+
+    for (auto const& change : added_entries)
+        section_of(change.section)->add_entry(change.key, change.value);
+
+    for (auto const& change : modified_entries)
+        section_of(change.section)->add_entry(change.key, change.value);
+}
+
+}  // namespace tom
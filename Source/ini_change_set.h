@@ -0,0 +1,41 @@
+#ifndef PARSEINI_INI_CHANGE_SET_H
+#define PARSEINI_INI_CHANGE_SET_H
+
+#include <string>
+#include <vector>
+#include "ini_file.h"
+
+namespace tom {
+
+// what changed between two versions of an ini file, see ini_watcher
+struct ini_change_set {
+    struct entry_change {
+        std::string section;
+        std::string key;
+        // empty for removed entries
+        std::string value;
+        // empty for added entries
+        std::string old_value;
+    };
+
+    std::vector<std::string> added_sections;
+    std::vector<std::string> removed_sections;
+    // sections in both versions whose entries differ
+    std::vector<std::string> modified_sections;
+
+    // the entries of added sections are listed here too, those of removed
+    // sections are not listed in removed_entries
+    std::vector<entry_change> added_entries;
+    std::vector<entry_change> removed_entries;
+    std::vector<entry_change> modified_entries;
+
+    [[nodiscard]] bool empty() const noexcept;
+
+    // brings file from the old version to the new one. Sections and entries
+    // that did not change are left alone, pointers to them stay valid
+    void apply_to(ini_file& file) const;
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_INI_CHANGE_SET_H
@@ -0,0 +1,294 @@
+#include "ini_document.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ini_handler.h"
+#include "ini_parser.h"
+#include "ini_writer.h"
+
+namespace tom {
+
+void ini_document::scan() {
+    spans.clear();
+
+    // records where sections and entries start and end. The parser reads
+    // text from memory, so the views it reports point into text
+    struct scanner final : ini_handler {
+        std::string_view           text;
+        char                       separator;
+        std::vector<section_span>& spans;
+
+        scanner(std::string_view text, char separator, std::vector<section_span>& spans) :
+            text(text), separator(separator), spans(spans) { }
+
+        std::size_t offset_of(std::string_view part) const {
+            return static_cast<std::size_t>(part.data() - text.data());
+        }
+
+        std::size_t line_begin(std::size_t at) const {
+            auto const found = at == 0 ? std::string_view::npos : text.rfind(separator, at - 1);
+            return found == std::string_view::npos ? 0 : found + 1;
+        }
+
+        std::size_t line_end(std::size_t at) const {
+            auto const found = text.find(separator, at);
+            return found == std::string_view::npos ? text.size() : found + 1;
+        }
+
+        bool on_section(std::string_view name) override {
+            // the default section's name is not part of the text
+            bool const header = name.data() >= text.data() && name.data() < text.data() + text.size();
+            auto const begin  = header ? line_begin(offset_of(name)) : 0;
+            auto const after  = header ? line_end(offset_of(name) + name.size()) : 0;
+
+            if (!spans.empty())
+                spans.back().end = begin;
+            spans.push_back(section_span{name, begin, text.size(), after, header});
+            return true;
+        }
+
+        bool on_entry(std::string_view key, std::string_view value) override {
+            auto const key_at   = offset_of(key);
+            // the value starts right after the '=' that ended the key
+            auto const value_at = key_at + key.size() + 1;
+            auto const end      = line_end(value_at + value.size());
+
+            auto& span = spans.back();
+            span.entries.push_back(entry_span{key, line_begin(key_at), value_at, value_at + value.size(), end});
+            span.insert_at = end;
+            return true;
+        }
+    } handler{text, line_separator, spans};
+
+    ini_parser parser{filename, text, nullptr, comment_chars, line_separator};
+    parser.parse(handler);
+}
+
+ini_document::ini_document(std::string filename_, std::vector<char> comment_chars_, char line_separator) :
+    filename(std::move(filename_)), comment_chars(std::move(comment_chars_)), line_separator(line_separator) {
+    loaded = source_stamp::of(filename);
+
+    std::ifstream in{filename, std::ios::binary};
+    if (!in)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + filename);
+    text.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{ });
+
+    ini_parser parser{filename, text, nullptr, comment_chars, line_separator};
+    tree = std::make_shared<ini_file>(parser.parse());
+    scan();
+}
+
+ini_file& ini_document::file() noexcept {
+    return *tree;
+}
+
+ini_file const& ini_document::file() const noexcept {
+    return *tree;
+}
+
+std::string_view ini_document::original() const noexcept {
+    return text;
+}
+
+void ini_document::diff_section(section_span const& span, ini_section const& live, std::vector<patch>& out) const {
+    // a key that appears more than once takes its value from the last time
+    std::unordered_map<std::string_view, std::size_t> last{ };
+    for (std::size_t i = 0; i < span.entries.size(); i++)
+        last[span.entries[i].key] = i;
+
+    for (std::size_t i = 0; i < span.entries.size(); i++) {
+        auto const& entry   = span.entries[i];
+        auto const  current = live.get_entry(entry.key);
+
+        // every occurrence goes, or the next parse would find an earlier one
+        if (current == nullptr) {
+            out.push_back(patch{entry.line_begin, entry.line_end - entry.line_begin, { }});
+            continue;
+        }
+        if (last[entry.key] != i)
+            continue;
+
+        auto const was = std::string_view{text}.substr(entry.value_begin, entry.value_end - entry.value_begin);
+        if (current->value_view() != was)
+            out.push_back(patch{entry.value_begin, was.size(), std::string{current->value_view()}});
+    }
+
+    std::string added{ };
+    for (auto const* entry : ini_writer::entries_in(live, write_order::insertion)) {
+        if (last.contains(entry->key_view()))
+            continue;
+        added.append(entry->key_view()).append(1, '=').append(entry->value_view()).append(1, line_separator);
+    }
+    if (added.empty())
+        return;
+
+    // the last line of the file may not be terminated
+    if (span.insert_at > 0 && text[span.insert_at - 1] != line_separator)
+        added.insert(added.begin(), line_separator);
+    out.push_back(patch{span.insert_at, 0, std::move(added)});
+}
+
+std::vector<ini_document::patch> ini_document::changes() const {
+    std::vector<patch> out{ };
+
+    // a section that appears more than once is parsed from the last time
+    std::unordered_map<std::string_view, std::size_t> last{ };
+    for (std::size_t i = 0; i < spans.size(); i++)
+        last[spans[i].name] = i;
+
+    for (std::size_t i = 0; i < spans.size(); i++) {
+        auto const& span    = spans[i];
+        auto const  current = tree->get_section(span.name);
+
+        if (current == nullptr) {
+            // the default section has no header, its comments are left alone
+            if (span.has_header) {
+                out.push_back(patch{span.begin, span.end - span.begin, { }});
+            } else {
+                for (auto const& entry : span.entries)
+                    out.push_back(patch{entry.line_begin, entry.line_end - entry.line_begin, { }});
+            }
+            continue;
+        }
+        if (last[span.name] == i)
+            diff_section(span, *current, out);
+    }
+
+    // new sections go at the end, after a blank line
+    std::string added{ };
+    for (auto const* section : ini_writer::sections_in(*tree, write_order::insertion)) {
+        if (last.contains(section->name))
+            continue;
+        added.append(1, line_separator).append(1, '[').append(section->name).append(1, ']').append(1, line_separator);
+        for (auto const* entry : ini_writer::entries_in(*section, write_order::insertion))
+            added.append(entry->key_view()).append(1, '=').append(entry->value_view()).append(1, line_separator);
+    }
+    if (added.empty())
+        return out;
+
+    // what the output ends with so far, earlier patches can reach the end too
+    std::string_view before = std::string_view{text};
+    if (!out.empty() && out.back().offset + out.back().length == text.size())
+        before = out.back().text.empty() ? before.substr(0, out.back().offset) : std::string_view{out.back().text};
+
+    if (before.empty())
+        added.erase(0, 1);
+    else if (before.back() != line_separator)
+        added.insert(added.begin(), line_separator);
+    out.push_back(patch{text.size(), 0, std::move(added)});
+
+    return out;
+}
+
+std::string ini_document::apply(std::vector<patch> const& patches) const {
+    std::string out{ };
+    out.reserve(text.size());
+    std::size_t at = 0;
+    for (auto const& each : patches) {
+        out.append(text, at, each.offset - at);
+        out.append(each.text);
+        at = each.offset + each.length;
+    }
+    out.append(text, at);
+    return out;
+}
+
+std::string ini_document::render() const {
+    return apply(changes());
+}
+
+void ini_document::write_patched(std::vector<patch> const& patches, std::string const& path) const {
+    // untouched ranges are written straight from the original text
+    std::vector<iovec> pieces{ };
+    std::size_t        at = 0;
+    auto const         add = [&pieces](char const* data, std::size_t size) {
+        if (size > 0)
+            pieces.push_back(iovec{const_cast<char*>(data), size});
+    };
+    for (auto const& each : patches) {
+        add(text.data() + at, each.offset - at);
+        add(each.text.data(), each.text.size());
+        at = each.offset + each.length;
+    }
+    add(text.data() + at, text.size() - at);
+
+    std::string const temporary = path + ".tmp";
+    int const         fd        = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + temporary);
+
+    try {
+        write_gathered(fd, pieces.data(), pieces.size());
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+
+    if (::close(fd) != 0) {
+        int const error = errno;
+        ::unlink(temporary.c_str());
+        throw std::system_error(error, std::generic_category(), "Cannot write " + temporary);
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot replace " + path);
+}
+
+bool ini_document::save() {
+    auto const patches = changes();
+    if (patches.empty())
+        return true;
+
+    bool in_place = std::all_of(patches.begin(), patches.end(), [](patch const& each) {
+        return each.text.size() == each.length;
+    });
+    try {
+        in_place = in_place && source_stamp::of(filename) == loaded;
+    } catch (std::system_error const&) {
+        in_place = false;
+    }
+
+    if (in_place) {
+        int const fd = ::open(filename.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "Cannot open " + filename);
+        for (auto const& each : patches) {
+            std::size_t done = 0;
+            while (done < each.text.size()) {
+                auto const n = ::pwrite(fd, each.text.data() + done, each.text.size() - done,
+                                        static_cast<off_t>(each.offset + done));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0) {
+                    int const error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(), "Cannot write " + filename);
+                }
+                done += static_cast<std::size_t>(n);
+            }
+            text.replace(each.offset, each.length, each.text);
+        }
+        if (::close(fd) != 0)
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + filename);
+    } else {
+        write_patched(patches, filename);
+        text = apply(patches);
+    }
+
+    loaded = source_stamp::of(filename);
+    scan();
+    return in_place;
+}
+
+void ini_document::save_as(std::string const& path) const {
+    write_patched(changes(), path);
+}
+
+}  // namespace tom
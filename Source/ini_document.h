@@ -0,0 +1,114 @@
+#ifndef PARSEINI_INI_DOCUMENT_H
+#define PARSEINI_INI_DOCUMENT_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ini_file.h"
+#include "ini_snapshot.h"
+
+namespace tom {
+
+// an ini file parsed along with a table of where each section and entry sits
+// in its original text. Edits are made to file() as usual, through
+// ini_section::add_entry, remove_entry and the like, and saving turns them
+// into patches of the original text: comments, blank lines, spacing and
+// order are kept, and untouched ranges are copied rather than re-formatted.
+//
+// A changed value replaces just the value's bytes and a removed entry its
+// line. A removed section takes everything up to the next header with it,
+// comments included. New entries go after the last entry of their section
+// and new sections are appended at the end
+class ini_document {
+public:
+    // a replacement of length bytes at offset by text. Insertions have length 0
+    struct patch {
+        std::size_t offset = 0;
+        std::size_t length = 0;
+        std::string text{ };
+    };
+
+private:
+    struct entry_span {
+        std::string_view key;
+        std::size_t      line_begin;
+        std::size_t      value_begin;
+        std::size_t      value_end;
+        std::size_t      line_end;
+    };
+
+    struct section_span {
+        std::string_view        name;
+        // the header line, or where the first entry starts for the default
+        // section, which has no header
+        std::size_t             begin;
+        // where the next section's header starts
+        std::size_t             end;
+        // after the last entry line, or after the header if there are none
+        std::size_t             insert_at;
+        bool                    has_header;
+        std::vector<entry_span> entries{ };
+    };
+
+    std::string                filename;
+    std::vector<char>          comment_chars;
+    char                       line_separator;
+    std::string                text{ };
+    std::vector<section_span>  spans{ };
+    std::shared_ptr<ini_file>  tree;
+    source_stamp               loaded{ };
+
+    // rebuilds spans from text
+    void scan();
+
+    // adds the patches turning span into live to out, in order of offset
+    void diff_section(section_span const& span, ini_section const& live, std::vector<patch>& out) const;
+
+    // text with patches applied
+    [[nodiscard]] std::string apply(std::vector<patch> const& patches) const;
+
+    void write_patched(std::vector<patch> const& patches, std::string const& path) const;
+
+public:
+    // reads and parses filename. Throws std::system_error if it cannot be read
+    // and parse_error if it cannot be parsed
+    explicit ini_document(
+        std::string filename,
+        std::vector<char> comment_chars = {'#', ';'},
+        char line_separator = '\n'
+    );
+
+    ini_document(ini_document const&) = delete;
+
+    ini_document& operator =(ini_document const&) = delete;
+
+    // the parsed file, edits made here are what save writes
+    ini_file& file() noexcept;
+
+    [[nodiscard]] ini_file const& file() const noexcept;
+
+    // the text as it was loaded or last saved
+    [[nodiscard]] std::string_view original() const noexcept;
+
+    // the smallest set of patches that turns original() into file()
+    [[nodiscard]] std::vector<patch> changes() const;
+
+    // original() with changes() applied
+    [[nodiscard]] std::string render() const;
+
+    // writes the changes back to the file it was loaded from. When every patch
+    // keeps its length and the file is unchanged on disk since it was loaded,
+    // only the patched bytes are written, in place. Otherwise the file is
+    // rewritten through a temporary file. Returns true if it patched in place
+    bool save();
+
+    // writes original() with the changes applied to path, the document still
+    // refers to its own file afterwards and its changes are kept
+    void save_as(std::string const& path) const;
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_INI_DOCUMENT_H
@@ -5,47 +5,120 @@
 
 namespace tom {
 
-ini_entry::ini_entry(ini_entry const& other) : key_(other.key()), value_(other.value()) { }
+namespace {
 
-ini_entry::ini_entry(ini_entry&& other) noexcept: key_(std::move(other.key_)), value_(std::move(other.value_)) { }
+std::any const* copy_cache(std::atomic<std::any const*> const& cache) {
+    auto const* cached = cache.load(std::memory_order_acquire);
+    return cached == nullptr ? nullptr : new std::any{*cached};
+}
+
+}  // namespace
+
+ini_entry::ini_entry(ini_entry const& other) :
+    key_(other.key_view()),
+    value_(other.value_view()),
+    typed_cache_(copy_cache(other.typed_cache_)) { }
+
+ini_entry::ini_entry(ini_entry&& other) noexcept:
+    key_borrowed_(other.key_borrowed_),
+    value_borrowed_(other.value_borrowed_),
+    key_view_(other.key_view_),
+    value_view_(other.value_view_),
+    key_(std::move(other.key_)),
+    value_(std::move(other.value_)),
+    typed_cache_(other.typed_cache_.exchange(nullptr)) { }
 
 ini_entry::ini_entry(std::weak_ptr<ini_section> parent, std::string key, std::string value) :
-    parent(parent), key_(std::move(key)), value_(std::move(value)) { }
+    key_(std::move(key)), value_(std::move(value)), parent(std::move(parent)) { }
+
+ini_entry::ini_entry(std::weak_ptr<ini_section> parent, std::string_view key, std::string_view value, borrowed_t) :
+    key_borrowed_(true), value_borrowed_(true), key_view_(key), value_view_(value), parent(std::move(parent)) { }
+
+ini_entry::ini_entry(std::weak_ptr<ini_section> parent, std::string_view key, std::string value, borrowed_key_t) :
+    key_borrowed_(true), key_view_(key), value_(std::move(value)), parent(std::move(parent)) { }
 
 ini_entry& ini_entry::operator =(ini_entry const& other) {
     if (&other != this) {
-        key_   = other.key();
-        value_ = other.value();
+        // other may view this entry's own strings, so copy before replacing
+        std::string value{other.value_view()};
+        if (sections_holding_ == 0) {
+            std::string key{other.key_view()};
+            key_borrowed_ = false;
+            key_view_     = { };
+            key_          = std::move(key);
+        }
+        value_borrowed_ = false;
+        value_view_     = { };
+        value_          = std::move(value);
+        delete typed_cache_.exchange(copy_cache(other.typed_cache_));
     }
     return *this;
 }
 
 ini_entry& ini_entry::operator =(ini_entry&& other) noexcept {
     if (&other != this) {
-        key_   = std::move(other.key_);
-        value_ = std::move(other.value_);
+        if (sections_holding_ == 0) {
+            key_borrowed_ = other.key_borrowed_;
+            key_view_     = other.key_view_;
+            key_          = std::move(other.key_);
+        }
+        value_borrowed_ = other.value_borrowed_;
+        value_view_     = other.value_view_;
+        value_          = std::move(other.value_);
+        delete typed_cache_.exchange(other.typed_cache_.exchange(nullptr));
     }
     return *this;
 }
 
 bool ini_entry::operator ==(ini_entry const& rhs) const noexcept {
     if (&rhs == this) return true;
-    return key_ == rhs.key_ && value_ == rhs.value_;
+    return key_view() == rhs.key_view() && value_view() == rhs.value_view();
 }
 
 ini_entry::operator std::tuple<std::string, std::string>() const {
-    return std::tie(key_, value_);
+    return std::tuple<std::string, std::string>{key(), value()};
 }
 
 bool ini_entry::operator !=(ini_entry const& rhs) const noexcept { return !(*this == rhs); }
 
-std::string const& ini_entry::key() const noexcept {
-    return key_;
+std::string ini_entry::key() const {
+    return std::string{key_view()};
+}
+
+std::string ini_entry::value() const {
+    return std::string{value_view()};
 }
 
-std::string const& ini_entry::value() const noexcept {
+std::string const& ini_entry::own_value() {
+    if (value_borrowed_) {
+        value_.assign(value_view_);
+        value_borrowed_ = false;
+        value_view_     = { };
+    }
     return value_;
 }
 
+std::string_view ini_entry::key_view() const noexcept {
+    return key_borrowed_ ? key_view_ : std::string_view{key_};
+}
+
+std::string_view ini_entry::value_view() const noexcept {
+    return value_borrowed_ ? value_view_ : std::string_view{value_};
+}
+
+bool ini_entry::is_borrowed() const noexcept {
+    return key_borrowed_ || value_borrowed_;
+}
+
+void ini_entry::set_value(std::string value) {
+    value_borrowed_ = false;
+    value_view_     = { };
+    value_          = std::move(value);
+    delete typed_cache_.exchange(nullptr);
+}
+
+ini_entry::~ini_entry() {
+    delete typed_cache_.load(std::memory_order_relaxed);
+}
 
 }  // namespace tom
@@ -5,58 +5,185 @@
 #ifndef PARSEINI_INI_ENTRY_H
 #define PARSEINI_INI_ENTRY_H
 
+#include <any>
+#include <atomic>
+#include <cstdint>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include "ini_section.h"
 #include "utils.h"
+#include "value_conversion.h"
 
 namespace tom {
 
 struct ini_entry {
 private:
-    std::string key_;
-    std::string value_;
+    // a borrowed key or value is not owned by the entry, key_view_ and
+    // value_view_ point into storage owned by the ini_file (the file mapping
+    // or a string_pool) and key_ and value_ stay empty. Reading an entry
+    // never writes to it, so a file may be read from many threads at once
+    bool             key_borrowed_   = false;
+    bool             value_borrowed_ = false;
+    std::string_view key_view_{ };
+    std::string_view value_view_{ };
+    std::string      key_;
+    std::string      value_;
+
+    // the value converted by cached_value, reset when the value changes. Set
+    // once, by the first reader to convert the value, and then only read, so
+    // concurrent readers may race to fill it but never see it change
+    mutable std::atomic<std::any const*> typed_cache_{nullptr};
+
+    // the value as an owned string, copied out of borrowed memory if need be
+    std::string const& own_value();
+
+    // the sections whose maps hold the entry. They and their files' key
+    // indexes view its key, so the key must not change while this is not 0
+    std::uint32_t sections_holding_ = 0;
+
+    // when the entry was added to its section, see ini_writer. Belongs to the
+    // section the entry sits in, so copies do not take it with them
+    std::uint64_t insertion_order_ = 0;
+
+    friend struct ini_section;
+    friend class ini_writer;
 
 public:
+    struct borrowed_t {
+        explicit borrowed_t() = default;
+    };
+
+    static constexpr borrowed_t borrowed{ };
+
+    struct borrowed_key_t {
+        explicit borrowed_key_t() = default;
+    };
+
+    static constexpr borrowed_key_t borrowed_key{ };
+
     std::weak_ptr<ini_section> parent;
 
     bool operator ==(ini_entry const& rhs) const noexcept;
 
     bool operator !=(ini_entry const& rhs) const noexcept;
 
+    // a copy owns its key and value, so it outlives the file it came from
     ini_entry(ini_entry const& other);
 
     ini_entry(ini_entry&& other) noexcept;
 
+    // an entry held by a section keeps its key and only takes other's value,
+    // remove it and add a new one to change the key
     ini_entry& operator =(ini_entry const& other);
 
     ini_entry& operator =(ini_entry&& other) noexcept;
 
     ini_entry(std::weak_ptr<ini_section> parent, std::string key, std::string value);
 
-    [[nodiscard]] std::string const& key() const noexcept;
+    // creates an entry that views key and value without copying them. The
+    // viewed memory must live as long as the entry, see ini_file::retain
+    ini_entry(std::weak_ptr<ini_section> parent, std::string_view key, std::string_view value, borrowed_t);
+
+    // as above, but only the key is viewed and the value is owned
+    ini_entry(std::weak_ptr<ini_section> parent, std::string_view key, std::string value, borrowed_key_t);
+
+    // owning access, a copy of the text. For a borrowed entry it is copied
+    // out of the borrowed memory on each call and the entry is not changed
+    [[nodiscard]] std::string key() const;
+
+    [[nodiscard]] std::string value() const;
+
+    // non-owning access that never copies, valid while the entry is and its
+    // value is not replaced
+    [[nodiscard]] std::string_view key_view() const noexcept;
+
+    [[nodiscard]] std::string_view value_view() const noexcept;
+
+    // true if the key or the value is borrowed
+    [[nodiscard]] bool is_borrowed() const noexcept;
 
-    [[nodiscard]] std::string const& value() const noexcept;
+    // replaces the value, which is owned from then on
+    void set_value(std::string value);
 
+    // numbers and bools are converted with convert_value and throw
+    // std::invalid_argument or std::out_of_range if the value is not one.
+    // Everything else is read from a std::stringstream
     template <typename T>
     struct adapt_to {
         static_assert(std::is_default_constructible<T>::value, "Can only adapt to default constructable types");
 
+        T operator ()(std::string_view value) {
+            if constexpr (is_convertible_value_v<T>) {
+                T          x{ };
+                auto const error = convert_value(value, x);
+                if (error == std::errc::result_out_of_range)
+                    throw std::out_of_range("Value out of range: " + std::string{value});
+                if (error != std::errc{ })
+                    throw std::invalid_argument("Cannot convert value: " + std::string{value});
+                return x;
+            } else {
+                return (*this)(std::string{value});
+            }
+        }
+
         T operator ()(std::string const& value) {
-            std::stringstream geek(value);
-            T                 x;
-            geek >> x;
-            return x;
+            if constexpr (is_convertible_value_v<T>) {
+                return (*this)(std::string_view{value});
+            } else {
+                std::stringstream geek(value);
+                T                 x;
+                geek >> x;
+                return x;
+            }
         }
     };
 
+    // adapters that take a std::string_view are given value_view(), so
+    // borrowed values are not copied out
     template <typename T, typename AdapterFunc = adapt_to<T> >
     T adapt_value(AdapterFunc adapter = adapt_to<T>{ }) const {
-        return adapter(value_);
+        if constexpr (std::is_invocable_v<AdapterFunc&, std::string_view>)
+            return adapter(value_view());
+        else
+            return adapter(std::string{value_view()});
+    }
+
+    // converts the value like adapt_value, but reports failure instead of
+    // throwing. out is only written on success
+    template <typename T>
+    std::errc try_adapt_value(T& out) const noexcept {
+        return convert_value(value_view(), out);
+    }
+
+    // adapt_value<T>() converted once and kept until the value changes, so
+    // later reads as the same T only check the type of the cached value.
+    // Only the first type asked for is kept, reads as any other T convert
+    // each time. Safe to call from several threads at once
+    template <typename T>
+    T cached_value() const {
+        static_assert(is_convertible_value_v<T>, "Only numbers and bools are cached");
+
+        auto const* cached = typed_cache_.load(std::memory_order_acquire);
+        if (cached != nullptr) {
+            if (auto const* value = std::any_cast<T>(cached))
+                return *value;
+            return adapt_value<T>();
+        }
+
+        T const converted = adapt_value<T>();
+        auto*   filled    = new std::any{converted};
+        if (!typed_cache_.compare_exchange_strong(cached, filled, std::memory_order_acq_rel))
+            delete filled;
+        return converted;
     }
 
     operator std::tuple<std::string, std::string>() const;
+
+    ~ini_entry();
 };
 
 }  // namespace tom
@@ -4,10 +4,87 @@
 
 #include "ini_file.h"
 
+#include <stdexcept>
+#include "frozen_ini_file.h"
+
 namespace tom {
 
 ini_file::ini_file(std::string name_) : name(std::move(name_)) { }
 
+ini_file::ini_file(ini_file&& other) noexcept :
+    smap(std::move(other.smap)),
+    lazy_section_cache(std::move(other.lazy_section_cache)),
+    retained(std::move(other.retained)),
+    key_index(std::move(other.key_index)),
+    hierarchy(std::move(other.hierarchy)),
+    pool(std::move(other.pool)),
+    next_section_order(other.next_section_order),
+    name(other.name) {
+    dirty = other.dirty;
+    for (auto const& [section_name, section] : smap)
+        if (section->index_owner == &other)
+            section->index_owner = this;
+}
+
+ini_file::~ini_file() {
+    // sections can outlive the file, they must not update a dead index
+    for (auto const& [section_name, section] : smap)
+        if (section->index_owner == this)
+            section->index_owner = nullptr;
+}
+
+void ini_file::index_key(std::string_view key, ini_section* section) {
+    auto it = key_index.find(key);
+    if (it == key_index.end())
+        it = key_index.emplace(key, std::vector<ini_section*>{ }).first;
+    it->second.push_back(section);
+}
+
+void ini_file::unindex_key(std::string_view key, ini_section* section) {
+    auto it = key_index.find(key);
+    if (it == key_index.end())
+        return;
+
+    auto& defining = it->second;
+    defining.erase(std::remove(defining.begin(), defining.end(), section), defining.end());
+    if (defining.empty()) {
+        key_index.erase(it);
+        return;
+    }
+
+    // the key may view the entry that is going away, the first section left
+    // has one that stays
+    auto const kept = defining.front()->emap.find(key)->first;
+    if (kept.data() != it->first.data()) {
+        auto node  = key_index.extract(it);
+        node.key() = kept;
+        key_index.insert(std::move(node));
+    }
+}
+
+void ini_file::repoint_key(std::string_view old_key, std::string_view new_key) {
+    auto it = key_index.find(old_key);
+    if (it == key_index.end() || it->first.data() != old_key.data())
+        return;
+    auto node  = key_index.extract(it);
+    node.key() = new_key;
+    key_index.insert(std::move(node));
+}
+
+void ini_file::index_section(ini_section* section) {
+    section->index_owner = this;
+    for (auto const& [key, entry] : section->emap)
+        index_key(key, section);
+    hierarchy.insert(section);
+}
+
+void ini_file::unindex_section(ini_section* section) {
+    for (auto const& [key, entry] : section->emap)
+        unindex_key(key, section);
+    hierarchy.erase(section);
+    section->index_owner = nullptr;
+}
+
 bool ini_file::add_section(std::string const& section_name, std::string* parent_name = nullptr) {
     dirty = true;
     auto const& parent = parent_name != nullptr ? get_section(*parent_name) : std::weak_ptr<ini_section>{ };
@@ -16,18 +93,41 @@ bool ini_file::add_section(std::string const& section_name, std::string* parent_
 }
 
 bool ini_file::add_section(std::shared_ptr<ini_section> section) {
+    // the key index of the other file would stop following its entries
+    if (section->index_owner != nullptr && section->index_owner != this)
+        throw std::invalid_argument("Section " + section->name + " is already part of another file");
+
     dirty = true;
-    auto exists = smap.find(section->name) != smap.end();
-    smap[section->name] = section;
-    return exists;
+    auto it = smap.find(section->name);
+    if (it != smap.end()) {
+        if (it->second == section)
+            return true;
+        unindex_section(it->second.get());
+        index_section(section.get());
+        section->insertion_order = it->second->insertion_order;
+        it->second               = std::move(section);
+        return true;
+    }
+
+    section->insertion_order = next_section_order++;
+    index_section(section.get());
+    smap.emplace(section->name, std::move(section));
+    return false;
 }
 
-void ini_file::remove_section(std::string const& name) {
+void ini_file::remove_section(std::string_view name) {
     dirty = true;
-    smap.erase(name);
+    if (auto it = smap.find(name); it != smap.end()) {
+        unindex_section(it->second.get());
+        smap.erase(it);
+    }
 }
 
-std::shared_ptr<ini_section> ini_file::get_section(std::string const& name) const {
+std::shared_ptr<ini_section> ini_file::get_section(std::string_view name) const {
+    return get_or_nullptr(smap, name);
+}
+
+std::shared_ptr<ini_section> ini_file::get_section(ini_key const& name) const {
     return get_or_nullptr(smap, name);
 }
 
@@ -36,35 +136,120 @@ std::vector<std::weak_ptr<ini_section>> ini_file::sections() const {
         lazy_section_cache = std::vector<std::weak_ptr<ini_section>>();
         std::for_each(std::cbegin(smap),
                       std::cend(smap),
-                      [this](auto a) { lazy_section_cache.push_back(std::get<1>(a)); });
+                      [this](auto const& a) { lazy_section_cache.push_back(std::get<1>(a)); });
         dirty = false;
     }
     return lazy_section_cache;
 }
 
-std::shared_ptr<ini_entry> ini_file::get_entry(std::string const& key) const {
-    auto ptr = sections();
-    for (auto& section : ptr)
-        if (auto entry = section.lock()->get_entry(key); entry != nullptr)
-            return entry;
+ini_file::section_range ini_file::each_section() {
+    return section_range{smap.cbegin(), smap.cend(), smap.size()};
+}
 
-    return nullptr;
+ini_file::const_section_range ini_file::each_section() const {
+    return const_section_range{smap.cbegin(), smap.cend(), smap.size()};
+}
+
+std::shared_ptr<ini_entry> ini_file::get_entry(std::string_view key) const {
+    return get_entry(ini_key{key});
+}
+
+std::shared_ptr<ini_entry> ini_file::get_entry(ini_key const& key) const {
+    auto it = key_index.find(key);
+    if (it == key_index.end())
+        return nullptr;
+    return it->second.front()->get_entry(key);
+}
+
+std::vector<std::shared_ptr<ini_section>> ini_file::sections_defining(std::string_view key) const {
+    return sections_defining(ini_key{key});
+}
+
+std::vector<std::shared_ptr<ini_section>> ini_file::sections_defining(ini_key const& key) const {
+    std::vector<std::shared_ptr<ini_section>> result{ };
+    if (auto it = key_index.find(key); it != key_index.end()) {
+        result.reserve(it->second.size());
+        for (auto* section : it->second)
+            result.push_back(section->shared_from_this());
+    }
+    return result;
 }
 
 ini_section& ini_file::operator [](std::string const& name) {
     dirty = true;
-    auto sec = get_or_nullptr(smap, name);
-    if (sec == nullptr) {
-        add_section(name);
-        sec = get_or_nullptr(smap, name);
+    if (auto it = smap.find(name); it != smap.end())
+        return *it->second;
+
+    add_section(name);
+    return *get_or_nullptr(smap, name);
+}
+
+std::vector<std::shared_ptr<ini_section>> ini_file::sections_under(std::string_view prefix) const {
+    std::vector<std::shared_ptr<ini_section>> result{ };
+    result.reserve(hierarchy.count(prefix));
+    hierarchy.visit(prefix, [&result](ini_section& section) { result.push_back(section.shared_from_this()); });
+    return result;
+}
+
+std::shared_ptr<ini_section> ini_file::parent_section(std::string_view name) const {
+    auto const above = hierarchy.ancestors(name);
+    return above.empty() ? nullptr : above.front()->shared_from_this();
+}
+
+std::shared_ptr<ini_entry> ini_file::get_inherited_entry(std::string_view section_name, std::string_view key) const {
+    ini_key const lookup{key};
+    if (auto const* section = hierarchy.find_section(section_name); section != nullptr)
+        if (auto entry = section->get_entry(lookup); entry != nullptr)
+            return entry;
+
+    for (auto const* section : hierarchy.ancestors(section_name))
+        if (auto entry = section->get_entry(lookup); entry != nullptr)
+            return entry;
+    return nullptr;
+}
+
+frozen_ini_file ini_file::freeze() const {
+    return frozen_ini_file{*this};
+}
+
+void ini_file::retain(std::shared_ptr<void const> storage) {
+    retained.push_back(std::move(storage));
+}
+
+void ini_file::use_string_pool(std::shared_ptr<string_pool> shared_pool) {
+    if (shared_pool != nullptr)
+        retain(shared_pool);
+    pool = std::move(shared_pool);
+}
+
+std::shared_ptr<string_pool> const& ini_file::key_pool() const noexcept {
+    return pool;
+}
+
+memory_report ini_file::memory_usage() const {
+    memory_report report{ };
+    for (auto const& [section_name, section] : smap) {
+        report += section->memory_usage();
+        report.strings += detail::heap_bytes(section_name);
     }
-    return *sec;
+    detail::count_map(smap, report);
+
+    // keys view entries' keys, only the section lists are the index's own
+    for (auto const& [key, defining] : key_index)
+        report.nodes += detail::vector_bytes(defining);
+    detail::count_map(key_index, report);
+
+    hierarchy.count_memory(report);
+
+    report.caches += detail::vector_bytes(lazy_section_cache);
+    if (pool != nullptr)
+        report.shared += pool->bytes();
+    return report;
 }
 
 std::ostream& operator <<(std::ostream& os, ini_file const& self) {
-    auto sections = self.sections();
-    for (auto const& section : sections)
-        os << *section.lock() << "\n";
+    for (auto const& section : self.each_section())
+        os << section << "\n";
 
     return os;
 
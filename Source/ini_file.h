@@ -5,6 +5,7 @@
 #ifndef PARSEINI_INI_FILE_H
 #define PARSEINI_INI_FILE_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -12,26 +13,68 @@
 #include <vector>
 #include "ini_entry.h"
 #include "ini_section.h"
+#include "memory_report.h"
+#include "section_trie.h"
+#include "string_pool.h"
 #include "utils.h"
 
 namespace tom {
 
+class frozen_ini_file;
+
 struct ini_file : std::enable_shared_from_this<ini_file> {
 private:
-    std::unordered_map<std::string, std::shared_ptr<ini_section>> smap{ };
+    string_map<std::shared_ptr<ini_section>> smap{ };
 
     // used for efficient key access through file
     mutable bool                                    dirty = true;
     mutable std::vector<std::weak_ptr<ini_section>> lazy_section_cache;
 
+    // storage that borrowed entries point into, such as the file mapping
+    std::vector<std::shared_ptr<void const>> retained;
+
+    // every key in the file and the sections defining it, in the order the
+    // sections were added. Kept up to date by add_section, remove_section and
+    // by ini_section::add_entry and remove_entry on sections in this file.
+    // Keys view the key of the entry in the first defining section
+    view_map<std::vector<ini_section*>> key_index{ };
+
+    // the sections by the dotted parts of their names, kept up to date along
+    // with key_index
+    section_trie hierarchy{ };
+
+    // where keys added to sections in this file are stored, if anywhere
+    std::shared_ptr<string_pool> pool{ };
+
+    // the stamp the next new section gets, see ini_section::insertion_order
+    std::uint64_t next_section_order = 0;
+
+    friend struct ini_section;
+
+    void index_key(std::string_view key, ini_section* section);
+
+    void unindex_key(std::string_view key, ini_section* section);
+
+    // the entry key_index viewed for key went away, new_key views its successor
+    void repoint_key(std::string_view old_key, std::string_view new_key);
+
+    void index_section(ini_section* section);
+
+    void unindex_section(ini_section* section);
+
 public:
+    using section_range       = pointee_range<string_map<std::shared_ptr<ini_section>>::const_iterator, ini_section>;
+    using const_section_range = pointee_range<string_map<std::shared_ptr<ini_section>>::const_iterator,
+                                              ini_section const>;
+
     std::string const name;
 
     ini_file() = delete;
 
     ini_file(const ini_file&) = delete;
 
-    ini_file(ini_file&&) = default;
+    // sections point back at the file that indexes them, so moving re-points them
+    ini_file(ini_file&& other) noexcept;
 
     ini_file& operator =(const ini_file&) = delete;
 
@@ -41,21 +84,78 @@ public:
 
     bool add_section(const std::string& section_name, std::string* parent_name);
 
+    // adds section, replacing any of the same name. A section is in one file
+    // at a time, std::invalid_argument is thrown if another file has it
     bool add_section(std::shared_ptr<ini_section> section);
 
-    void remove_section(std::string const& name);
+    void remove_section(std::string_view name);
+
+    std::shared_ptr<ini_section> get_section(std::string_view name) const;
 
-    std::shared_ptr<ini_section> get_section(std::string const& name) const;
+    std::shared_ptr<ini_section> get_section(ini_key const& name) const;
 
     [[nodiscard]] std::vector<std::weak_ptr<ini_section>> sections() const;
 
-    std::shared_ptr<ini_entry> get_entry(std::string const& key) const;
+    // iterates the sections in place without allocating or locking anything.
+    // Adding or removing sections invalidates the range
+    [[nodiscard]] section_range each_section();
+
+    [[nodiscard]] const_section_range each_section() const;
+
+    std::shared_ptr<ini_entry> get_entry(std::string_view key) const;
+
+    // the key's hash is reused for the lookup in every section
+    std::shared_ptr<ini_entry> get_entry(ini_key const& key) const;
+
+    // every section that defines key, in the order they were added
+    std::vector<std::shared_ptr<ini_section>> sections_defining(std::string_view key) const;
+
+    std::vector<std::shared_ptr<ini_section>> sections_defining(ini_key const& key) const;
 
     ini_section& operator [](std::string const& name);
 
+    // the section named prefix and every section below it in the dotted
+    // hierarchy, so "servers.eu" gives "servers.eu.db1" but not "servers.us".
+    // Parents come before children and siblings are ordered by name
+    [[nodiscard]] std::vector<std::shared_ptr<ini_section>> sections_under(std::string_view prefix) const;
+
+    // calls visit with each section sections_under(prefix) would return,
+    // without allocating. Sections must not be added or removed meanwhile
+    template <typename Visit>
+    void each_section_under(std::string_view prefix, Visit&& visit) const {
+        hierarchy.visit(prefix, [&visit](ini_section const& section) { visit(section); });
+    }
+
+    // the closest section whose name is a dotted prefix of name, nullptr if
+    // there is none. name itself need not be a section
+    [[nodiscard]] std::shared_ptr<ini_section> parent_section(std::string_view name) const;
+
+    // the entry for key in the section named section_name, or if it is not
+    // there, in the closest section above it that has one
+    [[nodiscard]] std::shared_ptr<ini_entry> get_inherited_entry(std::string_view section_name,
+                                                                 std::string_view key) const;
+
+    // an immutable copy for lookups only, see frozen_ini_file
+    [[nodiscard]] frozen_ini_file freeze() const;
+
+    // stores the keys of entries added to this file's sections from now on in
+    // pool, so each distinct key is stored once however many sections and
+    // files use it. The file retains the pool
+    void use_string_pool(std::shared_ptr<string_pool> shared_pool);
+
+    [[nodiscard]] std::shared_ptr<string_pool> const& key_pool() const noexcept;
+
+    // heap bytes held by this file, its sections and its indexes. The whole
+    // of the key pool is counted under shared, even if other files use it too
+    [[nodiscard]] memory_report memory_usage() const;
+
+    // keeps storage alive for as long as this file. Entries that borrow their
+    // key and value (see ini_entry::borrowed) must have their storage retained
+    void retain(std::shared_ptr<void const> storage);
+
     friend std::ostream& operator <<(std::ostream&, ini_file const&);
 
-    ~ini_file() = default;
+    ~ini_file();
 };
 
 }  // namespace tom
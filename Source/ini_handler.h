@@ -0,0 +1,34 @@
+#ifndef PARSEINI_INI_HANDLER_H
+#define PARSEINI_INI_HANDLER_H
+
+#include <string_view>
+#include "parse_error.h"
+
+namespace tom {
+
+// receives the contents of an ini file from ini_parser::parse(ini_handler&)
+// in the order they are read, with nothing kept in between. The views are
+// only valid during the call unless the parser maps its file. Returning false
+// from any callback stops the parse after that call
+class ini_handler {
+public:
+    virtual ~ini_handler() = default;
+
+    // a section header. Lines before the first header belong to a section
+    // named "<Default Section>", reported before the first of them
+    virtual bool on_section(std::string_view /* name */) { return true; }
+
+    // a key=value line, key and value are not trimmed
+    virtual bool on_entry(std::string_view /* key */, std::string_view /* value */) { return true; }
+
+    // the text of a comment after its comment char, up to the end of the line
+    virtual bool on_comment(std::string_view /* text */) { return true; }
+
+    // called while error is being handled, so the default's throw; rethrows it
+    // out of parse(). Returning true skips the rest of the line and goes on
+    virtual bool on_error(parse_error const& /* error */) { throw; }
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_INI_HANDLER_H
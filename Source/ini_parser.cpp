@@ -2,8 +2,14 @@
 // Created by Thomas Povinelli on 7/28/21.
 //
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
 #include "ini_parser.h"
+#include "thread_pool.h"
 #include "parse_error.h"
 #include "inistream.h"
 
@@ -20,41 +26,92 @@ void ini_parser::pop_section_() {
         current_section_ = current_section_->parent.lock();
 }
 
-std::size_t ini_parser::drop_space() {
-    const std::locale& locale = std::locale();
-    std::size_t n = 0;
+std::size_t ini_parser::opener_length() {
+    if (stream.eof())
+        return 0;
+    char const c = stream.peek();
+    if (short_openers_.is_stop(c))
+        return 1;
+    for (auto const& opener : long_openers_)
+        if (opener.front() == c && stream.starts_with(opener))
+            return opener.size();
+    return 0;
+}
 
-    while (std::isspace(stream.peek(), locale)) {
-        stream.consume();
-        n++;
+std::string_view ini_parser::consume_until(char_scanner const& stops, std::string& scratch) {
+    auto const find = [&stops](char const* first, std::size_t n) { return stops.find(first, n); };
+
+    // with only single char openers every stop is a real one, and this is
+    // one pass as it has always been
+    auto const false_stop = [this] {
+        return !long_openers_.empty() && !stream.eof() && comment_stops_.is_stop(stream.peek()) && opener_length() == 0;
+    };
+
+    std::string_view text;
+    if (stream.contiguous()) {
+        auto const start = stream.offset();
+        stream.consume_until(find, [](char const*, std::size_t) { });
+        while (false_stop()) {
+            stream.consume();
+            stream.consume_until(find, [](char const*, std::size_t) { });
+        }
+        text = stream.view(start);
+    } else {
+        scratch.clear();
+        auto const append = [&scratch](char const* first, std::size_t n) { scratch.append(first, n); };
+        stream.consume_until(find, append);
+        while (false_stop()) {
+            scratch.push_back(stream.consume());
+            stream.consume_until(find, append);
+        }
+        text = scratch;
     }
+
+    // "\r" of a "\r\n" terminator
+    if (!terminator_rest_.empty() && !stream.eof() && stream.peek() == line_separator && text.ends_with(terminator_rest_))
+        text.remove_suffix(terminator_rest_.size());
+    return text;
+}
+
+void ini_parser::skip_to_line_end() {
+    stream.consume_until([this](char const* first, std::size_t n) { return line_stops_.find(first, n); },
+                         [](char const*, std::size_t) { });
+}
+
+std::size_t ini_parser::drop_space() {
+    std::size_t n = 0;
+    stream.consume_until([this](char const* first, std::size_t count) { return line_stops_.skip_space(first, count); },
+                         [&n](char const*, std::size_t count) { n += count; });
     return n;
 }
 
 
-std::shared_ptr<ini_section> ini_parser::try_consume_section() {
+bool ini_parser::try_consume_section(std::string_view& name, std::optional<parse_diagnostic>& failure) {
     if (stream.peek() != '[')
-        return nullptr;
+        return false;
 
+    auto const opening = diagnostic_here(diagnostic_kind::unterminated_section);
     stream.consume(); // discard the opening [ section marker
 
-    char        c;
-    std::string name{};
-    while ((c = stream.consume()) != ']')
-        name.push_back(c);
+    name = consume_until(section_stops_, key_scratch_);
 
+    if (stream.eof() || stream.peek() != ']') {
+        failure = opening;
+        return false;
+    }
 
-    if (name.empty())
-        throw tom::empty_section_name("Cannot have section with empty name: " + current_pos_s());
+    stream.consume(); // discard the closing ] section marker
 
+    if (name.empty()) {
+        failure = diagnostic_here(diagnostic_kind::empty_section_name);
+        return false;
+    }
 
-    return std::make_shared<ini_section>(std::weak_ptr<ini_file>{inifile},
-                                         std::weak_ptr<ini_section>{current_section_},
-                                         name);
+    return true;
 }
 
 bool ini_parser::is_comment_char(char chr) const noexcept {
-    return std::any_of(begin(comment_chars), end(comment_chars), [chr](auto c) { return c == chr; });
+    return comment_stops_.is_stop(chr);
 }
 
 bool ini_parser::is_value_identifier_char(char c) const noexcept {
@@ -65,116 +122,517 @@ bool ini_parser::is_key_identifier_char(char c) const noexcept {
     return !is_comment_char(c) && c != line_separator && c != '=';
 }
 
-bool ini_parser::try_consume_comment() {
+bool ini_parser::try_consume_comment(std::string_view& text) {
     drop_space();
 
-    if (!is_comment_char(stream.peek())) {
+    auto const opener = opener_length();
+    if (opener == 0)
         return false;
-    }
 
-    while (stream.peek() != line_separator)
-        stream.consume();
+    for (std::size_t i = 0; i < opener; i++)
+        stream.consume(); // discard the comment opener
+
+    text = consume_until(line_stops_, value_scratch_);
 
     return true;
 }
 
-std::shared_ptr<ini_entry> ini_parser::try_consume_entry() {
-    std::string key{};
-    std::string value{};
-    char        c;
-
+bool ini_parser::try_consume_entry(std::string_view& key, std::string_view& value) {
     // after dropping initial whitespace, consume all valid key_ chars
-    while (is_key_identifier_char(stream.peek())) {
-        c = stream.consume();
-        key.push_back(c);
-    }
+    key = consume_until(key_stops_, key_scratch_);
 
     // If we reach the end of an identifier and don't find an equals, we have a
     // malformed line key_ with no value_
-    if (stream.peek() != '=')
-        return nullptr;
+    if (stream.eof() || stream.peek() != '=')
+        return false;
 
     stream.consume(); // discard equals sign
 
-    // repeat the process for the value_, but do not drop initial whitespace
-    while (is_value_identifier_char(stream.peek())) {
-        c = stream.consume();
-        value.push_back(c);
-    }
+    // repeat the process for the value_, but do not drop initial whitespace.
+    // What is left of the line is a comment, if anything
+    value = consume_until(value_stops_, value_scratch_);
+
+    return true;
+}
+
+namespace {
+
+char const* const default_section_name = "<Default Section>";
+
+std::shared_ptr<ini_entry> make_entry(
+    std::shared_ptr<ini_section> const& section,
+    std::string_view key,
+    std::string_view value,
+    bool borrow,
+    string_pool* pool
+) {
+    // pooled keys and views into the mapping stay valid as long as the
+    // ini_file retains the pool and the mapping
+    if (pool != nullptr)
+        key = pool->intern(key);
 
-    // cut the string to the new line so we can start fresh with the next line
-    while (stream.peek() != line_separator)
-        stream.consume();
+    if (borrow)
+        return std::make_shared<ini_entry>(std::weak_ptr<ini_section>{section}, key, value, ini_entry::borrowed);
 
+    if (pool != nullptr)
+        return std::make_shared<ini_entry>(std::weak_ptr<ini_section>{section}, key, std::string{value},
+                                           ini_entry::borrowed_key);
 
-    return std::make_shared<ini_entry>(std::weak_ptr<ini_section>{current_section_}, key, value);
+    return std::make_shared<ini_entry>(std::weak_ptr<ini_section>{section}, std::string{key}, std::string{value});
 }
 
-ini_file ini_parser::parse() {
-    while (!stream.eof()) {
-        drop_space();
+// builds the shared_ptr based ini_file. Sections are added to the file once
+// the next one begins, entries borrow from the input when borrow is set
+struct tree_builder final : ini_handler {
+    std::shared_ptr<ini_file> const& file;
+    std::shared_ptr<ini_section>&    current;
+    bool                             borrow;
+    string_pool*                     pool;
+
+    tree_builder(std::shared_ptr<ini_file> const& file, std::shared_ptr<ini_section>& current, bool borrow,
+                 string_pool* pool) :
+        file(file), current(current), borrow(borrow), pool(pool) { }
+
+    bool on_section(std::string_view name) override {
+        if (current != nullptr)
+            file->add_section(current);
+
+        current = std::make_shared<ini_section>(std::weak_ptr<ini_file>{file},
+                                                std::weak_ptr<ini_section>{current},
+                                                std::string{name});
+        return true;
+    }
 
-        auto sec = try_consume_section();
+    bool on_entry(std::string_view key, std::string_view value) override {
+        current->add_entry(make_entry(current, key, value, borrow, pool));
+        return true;
+    }
+};
+
+// builds the sections of one piece of a parallel parse, in the order they
+// appear, so they can be added to the file in that order afterwards
+struct chunk_builder final : ini_handler {
+    std::shared_ptr<ini_file> const&          file;
+    bool                                      borrow;
+    string_pool*                              pool;
+    std::vector<std::shared_ptr<ini_section>> sections{ };
+
+    chunk_builder(std::shared_ptr<ini_file> const& file, bool borrow, string_pool* pool) :
+        file(file), borrow(borrow), pool(pool) { }
+
+    bool on_section(std::string_view name) override {
+        std::weak_ptr<ini_section> previous{ };
+        if (!sections.empty())
+            previous = sections.back();
+
+        sections.push_back(std::make_shared<ini_section>(std::weak_ptr<ini_file>{file}, previous, std::string{name}));
+        return true;
+    }
 
-        if (sec != nullptr) {
-            if (current_section_ != nullptr)
-                inifile->add_section(current_section_);
+    bool on_entry(std::string_view key, std::string_view value) override {
+        sections.back()->add_entry(make_entry(sections.back(), key, value, borrow, pool));
+        return true;
+    }
+};
 
-            current_section_ = std::shared_ptr<ini_section>(sec);
+struct arena_builder final : ini_handler {
+    arena_ini_file&                file;
+    bool                           borrow;
+    arena_ini_file::section_handle current{ };
 
-            drop_space();
-            continue;
-        } else {
-            if (current_section_ == nullptr)
-                current_section_ = std::make_shared<ini_section>(std::weak_ptr<ini_file>{inifile},
-                                                                 std::weak_ptr<ini_section>{},
-                                                                 std::string("<Default Section>"));
-        }
+    arena_builder(arena_ini_file& file, bool borrow) : file(file), borrow(borrow) { }
 
-        // consume comment first to check for # at line
-        bool i = try_consume_comment();
-        if (i) {
-            drop_space();
-            continue;
-        }
+    bool on_section(std::string_view name) override {
+        current = borrow ? file.add_section_borrowed(name) : file.add_section(name);
+        return true;
+    }
+
+    bool on_entry(std::string_view key, std::string_view value) override {
+        if (borrow)
+            file.add_entry_borrowed(current, key, value);
+        else
+            file.add_entry(current, key, value);
+        return true;
+    }
+};
+
+}  // namespace
 
-        auto entry = try_consume_entry();
+template <typename Handler>
+bool ini_parser::parse_with(Handler& handler, std::vector<parse_diagnostic>* diagnostics) {
+    bool             in_section = false;
+    bool             going      = true;
+    std::string_view name, key, value, comment;
 
-        if (entry != nullptr) {
-            current_section_->add_entry(std::shared_ptr<ini_entry>(entry));
-            drop_space();
+    while (going && !stream.eof()) {
+        drop_space();
+
+        // trailing whitespace at the end of the file
+        if (stream.eof())
+            break;
+
+        auto const line = std::get<1>(stream.position());
+
+        std::optional<parse_diagnostic> failure{ };
+        if (try_consume_section(name, failure)) {
+            going      = handler.on_section(name);
+            in_section = true;
             continue;
         }
 
-        // consume comment again to see if line ends with a comment
-        i = try_consume_comment();
-        if (i) {
-            drop_space();
-            continue;
+        if (failure == std::nullopt) {
+            if (!in_section) {
+                in_section = true;
+                if (!handler.on_section(default_section_name))
+                    return false;
+            }
+
+            // consume comment first to check for # at line
+            if (try_consume_comment(comment)) {
+                going = handler.on_comment(comment);
+                continue;
+            }
+
+            if (try_consume_entry(key, value)) {
+                going = handler.on_entry(key, value);
+                continue;
+            }
+
+            // consume comment again to see if line ends with a comment. Only
+            // one on this line will do, the next line is not part of this one
+            auto const malformed = diagnostic_here(diagnostic_kind::malformed_line);
+            if (opener_length() != 0 && try_consume_comment(comment)) {
+                going = handler.on_comment(comment);
+                continue;
+            }
+
+            failure = malformed;
+        }
+
+        if (diagnostics != nullptr) {
+            diagnostics->push_back(*failure);
+        } else {
+            // on_error is called while the error is being handled, see ini_handler
+            try {
+                throw_error(*failure);
+            } catch (tom::parse_error const& error) {
+                going = handler.on_error(error);
+            }
         }
 
-        std::string s = current_pos_s();
-        throw tom::parse_error(s);
+        // the error can be found after moving on to the next line, which
+        // is then parsed as usual
+        if (going && std::get<1>(stream.position()) == line)
+            skip_to_line_end();
+    }
+
+    return going;
+}
+
+ini_file ini_parser::build(std::vector<parse_diagnostic>* diagnostics) {
+    if (mapping != nullptr)
+        inifile->retain(mapping);
+    if (pool != nullptr)
+        inifile->use_string_pool(pool);
+
+    tree_builder builder{inifile, current_section_, mapping != nullptr, pool.get()};
+    parse_with(builder, diagnostics);
+
+    // the last section is added here, an empty file has no sections at all,
+    // not even the default one
+    if (current_section_ != nullptr)
+        inifile->add_section(current_section_);
+
+    return std::move(*inifile);
+}
+
+ini_file ini_parser::parse() {
+    return build(nullptr);
+}
+
+parse_result ini_parser::parse_collecting() {
+    std::vector<parse_diagnostic> diagnostics{ };
+    ini_file                      file = build(&diagnostics);
+    return parse_result{std::move(file), std::move(diagnostics)};
+}
+
+bool ini_parser::parse(ini_handler& handler) {
+    return parse_with(handler);
+}
+
+bool ini_parser::parse(ini_handler& handler, std::vector<parse_diagnostic>& diagnostics) {
+    return parse_with(handler, &diagnostics);
+}
+
+arena_ini_file ini_parser::parse_arena() {
+    // the arena holds the records, and the text too unless it is borrowed
+    arena_ini_file file{filename, mapping != nullptr ? mapping->size() : 64 * 1024};
+    if (mapping != nullptr)
+        file.retain(mapping);
+
+    arena_builder builder{file, mapping != nullptr};
+    parse_with(builder);
+
+    return file;
+}
+
+std::vector<std::string_view> split_at_sections(std::string_view text, char line_separator, std::size_t parts) {
+    std::vector<std::string_view> pieces{ };
+    char const                    boundary_chars[] = {line_separator, '['};
+    std::string_view const        boundary{boundary_chars, 2};
+    std::size_t const             target = parts == 0 ? 0 : text.size() / parts;
+
+    // a piece starts at the '[' just after the separator that was found
+    std::size_t start = 0;
+    for (std::size_t k = 1; parts == 0 || k < parts; k++) {
+        auto const at = text.find(boundary, std::max(k * target, start));
+        if (at == std::string_view::npos)
+            break;
+        pieces.push_back(text.substr(start, at + 1 - start));
+        start = at + 1;
+    }
+    pieces.push_back(text.substr(start));
+    return pieces;
+}
+
+ini_file ini_parser::parse_parallel(unsigned threads, std::size_t min_chunk_size) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // the pieces are cut from memory, so buffered mode maps the file just for
+    // the parse and its entries copy what they need. Streams cannot be mapped
+    std::shared_ptr<mapped_file> contents = mapping;
+    std::string_view             text     = memory;
+    if (!stream.contiguous()) {
+        if (!stream.reads_named_file())
+            return parse();
+        contents = std::make_shared<mapped_file>(filename);
+        text     = contents->view();
     }
 
-    inifile->add_section(current_section_);
+    std::size_t const parts = std::min<std::size_t>(threads, text.size() / std::max<std::size_t>(min_chunk_size, 1));
+    if (parts <= 1)
+        return parse();
+
+    auto const pieces = split_at_sections(text, line_separator, parts);
+
+    std::vector<std::vector<std::shared_ptr<ini_section>>> results(pieces.size());
+    std::vector<std::exception_ptr>                        errors(pieces.size());
+    std::atomic<std::size_t>                               remaining{pieces.size()};
+    thread_pool&                                           workers = thread_pool::shared();
+
+    for (std::size_t i = 0; i < pieces.size(); i++) {
+        workers.submit([this, i, &pieces, &results, &errors, &remaining] {
+            try {
+                ini_parser    piece{filename, pieces[i], mapping, syntax};
+                chunk_builder builder{inifile, mapping != nullptr, pool.get()};
+                piece.parse_with(builder);
+                results[i] = std::move(builder.sections);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            remaining--;
+        });
+    }
+    workers.run_until([&remaining] { return remaining == 0; });
+
+    // a piece can fail where the whole file would not (a section name running
+    // over a line for instance), and error positions are relative to the
+    // piece. Parsing the whole file again gets both exactly right
+    if (std::any_of(errors.begin(), errors.end(), [](auto const& error) { return error != nullptr; })) {
+        ini_parser whole{filename, text, mapping, syntax};
+        whole.pool = pool;
+        return whole.parse();
+    }
+
+    if (mapping != nullptr)
+        inifile->retain(mapping);
+    if (pool != nullptr)
+        inifile->use_string_pool(pool);
+
+    // adding in order keeps "the later duplicate wins" for sections as well as
+    // the previous-section parent links the sequential parse makes
+    std::shared_ptr<ini_section> previous{ };
+    for (auto& sections : results) {
+        if (!sections.empty() && previous != nullptr && sections.front()->parent.expired())
+            sections.front()->parent = previous;
+        for (auto& section : sections) {
+            inifile->add_section(section);
+            previous = section;
+        }
+    }
 
     return std::move(*inifile);
 }
 
+bool ini_parser::is_open() const {
+    return stream.is_open();
+}
+
+read_ahead_stats ini_parser::io_stats() const {
+    auto const* reader = stream.reader();
+    return reader != nullptr ? reader->stats() : read_ahead_stats{ };
+}
+
+void ini_parser::use_string_pool(std::shared_ptr<string_pool> shared_pool) {
+    pool = std::move(shared_pool);
+}
+
 std::string ini_parser::current_pos_s() const {
-    std::stringstream s{};
-    auto const [cpos, cline, cline_pos] = stream.position();
-    s << "INI Parsing of " << get_filename() << " has failed at line: " << cline << ", col: "
-      << cline_pos << " (" << cpos << ")";
-    return s.str();
-}
-
-ini_parser::ini_parser(std::string const& filename, std::vector<char> comment_chars, char line_separator) :
-    inifile(std::make_unique<ini_file>(filename)),
-    filename(filename),
-    stream(inistream{filename}),
-    comment_chars(std::move(comment_chars)),
-    line_separator(line_separator) { }
+    return diagnostic_here(diagnostic_kind::malformed_line).message(filename);
+}
+
+parse_diagnostic ini_parser::diagnostic_here(diagnostic_kind kind) const {
+    auto const [offset, line, column] = stream.position();
+    return parse_diagnostic{kind, line, column, offset};
+}
+
+void ini_parser::throw_error(parse_diagnostic const& where) const {
+    if (where.kind == diagnostic_kind::empty_section_name)
+        throw tom::empty_section_name(where.message(filename));
+    throw tom::parse_error(where.message(filename));
+}
+
+namespace {
+
+// the char that ends a line
+char line_end(ini_syntax const& syntax) {
+    if (syntax.line_terminator.empty())
+        throw std::invalid_argument("The line terminator cannot be empty");
+    return syntax.line_terminator.back();
+}
+
+std::vector<char> first_chars(std::vector<std::string> const& openers) {
+    std::vector<char> chars{ };
+    for (auto const& opener : openers)
+        if (!opener.empty() && std::find(chars.begin(), chars.end(), opener.front()) == chars.end())
+            chars.push_back(opener.front());
+    return chars;
+}
+
+std::string short_openers(std::vector<std::string> const& openers) {
+    std::string chars{ };
+    for (auto const& opener : openers)
+        if (opener.size() == 1)
+            chars += opener;
+    return chars;
+}
+
+std::vector<std::string> long_openers(std::vector<std::string> const& openers) {
+    std::vector<std::string> longer{ };
+    for (auto const& opener : openers)
+        if (opener.size() > 1)
+            longer.push_back(opener);
+    return longer;
+}
+
+}  // namespace
+
+ini_syntax::ini_syntax(std::vector<std::string> comment_openers_, std::string line_terminator_) :
+    comment_openers(std::move(comment_openers_)), line_terminator(std::move(line_terminator_)) {
+    if (line_terminator.empty())
+        throw std::invalid_argument("The line terminator cannot be empty");
+    comment_openers.erase(std::remove_if(comment_openers.begin(), comment_openers.end(),
+                                         [](std::string const& opener) { return opener.empty(); }),
+                          comment_openers.end());
+}
+
+ini_syntax::ini_syntax(std::vector<char> const& comment_chars, char line_separator) :
+    comment_openers{ }, line_terminator(1, line_separator) {
+    for (char c : comment_chars)
+        comment_openers.emplace_back(1, c);
+}
+
+template <typename Open>
+ini_parser::ini_parser(
+    ini_syntax syntax_, std::string const& name, std::shared_ptr<mapped_file> backing, std::string_view contents,
+    Open open
+) :
+    inifile(std::make_unique<ini_file>(name)),
+    filename(name),
+    mapping(std::move(backing)),
+    memory(contents),
+    stream(open(mapping, contents, line_end(syntax_))),
+    syntax(std::move(syntax_)),
+    comment_chars(first_chars(syntax.comment_openers)),
+    line_separator(line_end(syntax)),
+    comment_stops_(std::string_view{comment_chars.data(), comment_chars.size()}),
+    key_stops_(std::string(comment_chars.begin(), comment_chars.end()) + line_separator + '='),
+    value_stops_(std::string(comment_chars.begin(), comment_chars.end()) + line_separator),
+    line_stops_(std::string(1, line_separator)),
+    section_stops_(std::string{"]"} + line_separator),
+    short_openers_(short_openers(syntax.comment_openers)),
+    long_openers_(long_openers(syntax.comment_openers)),
+    terminator_rest_(syntax.line_terminator, 0, syntax.line_terminator.size() - 1) { }
+
+ini_parser::ini_parser(
+    std::string const& filename, std::vector<char> comment_chars, char line_separator, input_mode mode
+) :
+    ini_parser(filename, ini_syntax{comment_chars, line_separator}, mode) { }
+
+ini_parser::ini_parser(std::string const& filename, ini_syntax syntax, input_mode mode) :
+    ini_parser(std::move(syntax), filename,
+               mode == input_mode::mapped ? std::make_shared<mapped_file>(filename) : nullptr, { },
+               [&filename, mode](std::shared_ptr<mapped_file> const& mapping, std::string_view, char separator) {
+                   if (mapping != nullptr)
+                       return inistream<>{mapping->view(), separator};
+                   if (mode == input_mode::read_ahead)
+                       return inistream<>{std::make_unique<read_ahead_reader>(filename), filename, separator};
+                   return inistream<>{filename, separator};
+               }) {
+    if (mapping != nullptr)
+        memory = mapping->view();
+}
+
+ini_parser::ini_parser(
+    std::string const& filename, std::string_view contents, std::shared_ptr<mapped_file> backing, ini_syntax syntax
+) :
+    ini_parser(std::move(syntax), filename, std::move(backing), contents,
+               [](std::shared_ptr<mapped_file> const&, std::string_view contents, char separator) {
+                   return inistream<>{contents, separator};
+               }) { }
+
+ini_parser::ini_parser(
+    std::string const& filename,
+    std::string_view contents,
+    std::shared_ptr<mapped_file> backing,
+    std::vector<char> comment_chars,
+    char line_separator
+) :
+    ini_parser(filename, contents, std::move(backing), ini_syntax{comment_chars, line_separator}) { }
+
+ini_parser::ini_parser(std::istream& input, std::string const& name, ini_syntax syntax) :
+    ini_parser(std::move(syntax), name, nullptr, { },
+               [&input, &name](std::shared_ptr<mapped_file> const&, std::string_view, char separator) {
+                   return inistream<>{input, name, separator};
+               }) { }
+
+ini_parser::ini_parser(int fd, std::string const& name, ini_syntax syntax) :
+    ini_parser(std::move(syntax), name, nullptr, { },
+               [fd, &name](std::shared_ptr<mapped_file> const&, std::string_view, char separator) {
+                   return inistream<>{fd, name, separator};
+               }) { }
+
+ini_parser::ini_parser(read_ahead_options options, std::string const& filename, ini_syntax syntax) :
+    ini_parser(std::move(syntax), filename, nullptr, { },
+               [options, &filename](std::shared_ptr<mapped_file> const&, std::string_view, char separator) {
+                   return inistream<>{std::make_unique<read_ahead_reader>(filename, options), filename, separator};
+               }) { }
+
+ini_parser ini_parser::from_buffer(std::string_view contents, std::string const& name, ini_syntax syntax) {
+    return ini_parser{name, contents, nullptr, std::move(syntax)};
+}
+
+ini_parser ini_parser::from_stream(std::istream& input, std::string const& name, ini_syntax syntax) {
+    return ini_parser{input, name, std::move(syntax)};
+}
+
+ini_parser ini_parser::from_fd(int fd, std::string const& name, ini_syntax syntax) {
+    return ini_parser{fd, name, std::move(syntax)};
+}
+
+ini_parser ini_parser::with_read_ahead(std::string const& filename, read_ahead_options options, ini_syntax syntax) {
+    return ini_parser{options, filename, std::move(syntax)};
+}
 
 }  // namespace tom
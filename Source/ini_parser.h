@@ -5,58 +5,206 @@
 #ifndef PARSEINI_INI_PARSER_H
 #define PARSEINI_INI_PARSER_H
 
+#include <istream>
 #include <memory>
+#include <optional>
 #include <string>
 #include "ini_file.h"
+#include "arena_ini_file.h"
 #include "utils.h"
 #include "parse_error.h"
+#include "parse_diagnostic.h"
 #include "inistream.h"
+#include "mapped_file.h"
+#include "char_scanner.h"
+#include "ini_handler.h"
+#include "string_pool.h"
+#include "read_ahead_reader.h"
 #include <array>
+#include <string_view>
 
 namespace tom {
 
 namespace {
 }
 
+// how ini_parser gets at the contents of the file
+enum class input_mode {
+    // reads the file through inistream's fixed size buffer. Keys and values are
+    // copied into entries that own them
+    buffered,
+    // maps the whole file into memory. Entries borrow their keys and values
+    // straight from the mapping, which the resulting ini_file keeps alive
+    mapped,
+    // reads large blocks on a background thread while the previous one is
+    // parsed, see read_ahead_reader. Entries copy like buffered ones
+    read_ahead
+};
+
+// the comment openers and line terminator a file is written with. Openers
+// and terminators may be several chars long, like "//" or "\r\n". Only the
+// last char of the terminator ends a line, the chars before it are dropped
+// from the end of the line when they are there, so "\r\n" also reads
+// files that end lines with just "\n"
+struct ini_syntax {
+    std::vector<std::string> comment_openers{"#", ";"};
+    std::string              line_terminator{"\n"};
+
+    ini_syntax() = default;
+
+    // throws std::invalid_argument if line_terminator is empty
+    ini_syntax(std::vector<std::string> comment_openers, std::string line_terminator = "\n");
+
+    // single char openers and separator, as ini_parser has always taken them
+    ini_syntax(std::vector<char> const& comment_chars, char line_separator = '\n');
+};
+
+// what ini_parser::parse_collecting found. The file holds everything that
+// could be parsed
+struct parse_result {
+    ini_file                      file;
+    std::vector<parse_diagnostic> diagnostics{ };
+
+    // true if there were no problems
+    explicit operator bool() const noexcept { return diagnostics.empty(); }
+};
+
 class ini_parser {
     // conetent fields
-    std::shared_ptr<ini_file> inifile;
-    std::string               filename;
-    inistream<>               stream;
+    std::shared_ptr<ini_file>   inifile;
+    std::string                 filename;
+    std::shared_ptr<mapped_file> mapping;
+    std::shared_ptr<string_pool> pool;
+    // the whole input when it is in memory already, mapped or given as a buffer
+    std::string_view            memory{ };
+    inistream<>                 stream;
 
     // parameterized fields
+    ini_syntax        syntax{ };
+    // the first char of each comment opener, and the char that ends a line
     std::vector<char> comment_chars  = {'#', ';'};
     char              line_separator = '\n';
 
+    // stop sets for the scanners, built once from the parameterized fields
+    char_scanner comment_stops_;
+    char_scanner key_stops_;
+    char_scanner value_stops_;
+    char_scanner line_stops_;
+    char_scanner section_stops_;
+
+    // openers that are a single char, those that are longer, and what comes
+    // before line_separator in the terminator. Scans stop at the first char of
+    // an opener and at line_separator, these say whether that is really one
+    char_scanner             short_openers_;
+    std::vector<std::string> long_openers_;
+    std::string              terminator_rest_;
+
     // implementation fields
     std::shared_ptr<ini_section> current_section_{};
 
+    // reused for keys and values when the stream is not contiguous
+    std::string key_scratch_{};
+    std::string value_scratch_{};
+
     // sets the current section to the current section's parent if it exists
     void pop_section_();
 
+    // consumes chars up to the first of stops. On a contiguous stream the
+    // result views the input, otherwise the chars are copied into scratch and
+    // the result views scratch until the next call using it. A stop at the
+    // first char of a long comment opener that is not followed by the rest of
+    // it is taken as text, and the rest of a line terminator is dropped
+    std::string_view consume_until(char_scanner const& stops, std::string& scratch);
+
+    // the length of the comment opener the next chars start, 0 if none
+    std::size_t opener_length();
+
+    // consumes the rest of the line up to (but not including) the line separator
+    void skip_to_line_end();
+
     // removes all initial whitespace from the string until the first non-space
     // char returns the number of chars removed or 0 if none are removed
     std::string::size_type drop_space();
 
     // trys to parse out a section in the ini file. If it cannot it returns
-    // nullptr otherwise it returns a freshly new'd section
+    // false otherwise it returns true and name views the section's name
     // this method does not change the whitespace, and a \n will still be present
-    // after it runs
-    std::shared_ptr<ini_section> try_consume_section();
+    // after it runs. If the line starts a section that cannot be one, failure
+    // says why and where. A name does not run past the end of its line
+    bool try_consume_section(std::string_view& name, std::optional<parse_diagnostic>& failure);
 
-    // trys to parse out a entry in the ini file. If it cannot it returns nullptr
-    // otherwise it returns a freshly new'd entry
+    // trys to parse out a entry in the ini file. If it cannot it returns false
+    // otherwise it returns true and key and value view the entry's text
     // this method does not change the whitespace, and a \n will still be present
     // after it runs
-    std::shared_ptr<ini_entry> try_consume_entry();
+    bool try_consume_entry(std::string_view& key, std::string_view& value);
 
     // trys to parse out a comment in the ini file. If it cannot it returns
-    // false otherwise if it does it returns true
-    bool try_consume_comment();
+    // false otherwise it returns true and text views the comment after its
+    // comment char
+    bool try_consume_comment(std::string_view& text);
 
     std::string current_pos_s() const;
 
+    // a problem of the given kind at the current position
+    [[nodiscard]] parse_diagnostic diagnostic_here(diagnostic_kind kind) const;
+
+    // throws the parse_error (or subclass of it) parse() reports where with
+    [[noreturn]] void throw_error(parse_diagnostic const& where) const;
+
+    // runs the parse, calling handler's callbacks in order. Instantiated with
+    // the concrete builders so their callbacks are not called virtually.
+    // Returns false if a callback stopped the parse. Problems go to
+    // diagnostics if it is set, and the parse goes on at the next line, or
+    // are thrown to handler.on_error otherwise
+    template <typename Handler>
+    bool parse_with(Handler& handler, std::vector<parse_diagnostic>* diagnostics = nullptr);
+
+    // parse() and parse_collecting()
+    ini_file build(std::vector<parse_diagnostic>* diagnostics);
+
+    // parses the pieces of a file it watches
+    friend class ini_watcher;
+
+    // parses the text of a document it keeps in memory
+    friend class ini_document;
+
+    // sets up everything but the input, which open(mapping, contents,
+    // line_separator) makes. contents is the whole input if it is in memory
+    template <typename Open>
+    ini_parser(
+        ini_syntax syntax,
+        std::string const& name,
+        std::shared_ptr<mapped_file> backing,
+        std::string_view contents,
+        Open open
+    );
+
+    // parses contents, which is already in memory. If backing is set, contents
+    // must lie within it and entries borrow from it, otherwise they copy
+    ini_parser(
+        std::string const& filename,
+        std::string_view contents,
+        std::shared_ptr<mapped_file> backing,
+        ini_syntax syntax
+    );
+
+    ini_parser(
+        std::string const& filename,
+        std::string_view contents,
+        std::shared_ptr<mapped_file> backing,
+        std::vector<char> comment_chars,
+        char line_separator
+    );
+
+    ini_parser(std::istream& input, std::string const& name, ini_syntax syntax);
+
+    ini_parser(int fd, std::string const& name, ini_syntax syntax);
+
+    ini_parser(read_ahead_options options, std::string const& filename, ini_syntax syntax);
+
 public:
+    // true if chr is the first char of a comment opener
     bool is_comment_char(char chr) const noexcept;
 
     bool is_value_identifier_char(char c) const noexcept;
@@ -64,21 +212,102 @@ public:
     bool is_key_identifier_char(char c) const noexcept;
 
     explicit ini_parser(
-        std::string const& filename, std::vector<char> comment_chars = {'#', ';'}, char line_separator = '\n'
+        std::string const& filename,
+        std::vector<char> comment_chars = {'#', ';'},
+        char line_separator = '\n',
+        input_mode mode = input_mode::buffered
+    );
+
+    // parses filename written with syntax, such as {{"//", "#"}, "\r\n"}
+    ini_parser(std::string const& filename, ini_syntax syntax, input_mode mode = input_mode::buffered);
+
+    // parses contents straight from memory, without copying it into a read
+    // buffer first. Entries copy their keys and values, so contents only has
+    // to outlive the parse. name stands in for the filename in errors and in
+    // the resulting ini_file
+    static ini_parser from_buffer(
+        std::string_view contents,
+        std::string const& name = "<buffer>",
+        ini_syntax syntax = { }
+    );
+
+    // parses what is left of input, which must outlive the parse
+    static ini_parser from_stream(
+        std::istream& input,
+        std::string const& name = "<stream>",
+        ini_syntax syntax = { }
+    );
+
+    // parses what is left to read from fd, a file, pipe or socket. fd is not
+    // closed. Throws std::system_error if reading fails
+    static ini_parser from_fd(
+        int fd,
+        std::string const& name = "<fd>",
+        ini_syntax syntax = { }
+    );
+
+    // reads filename in read_ahead mode with blocks of the given size and
+    // count. Throws std::system_error if it cannot be opened
+    static ini_parser with_read_ahead(
+        std::string const& filename,
+        read_ahead_options options,
+        ini_syntax syntax = { }
     );
 
     // the main method the user of this class will call. Takes the content of the
     // file and parses it into the ini_file data structure
     ini_file parse();
 
+    // parses like parse() but never throws for malformed input. Each problem
+    // is recorded in the result and the parse goes on at the next line, so
+    // every problem in the file is found in one pass. No message text is made
+    // unless parse_diagnostic::message is called
+    parse_result parse_collecting();
+
+    // runs the parse without building anything, reporting what it reads to
+    // handler instead. Returns false if the handler stopped it early
+    bool parse(ini_handler& handler);
+
+    // like parse(handler), but problems are added to diagnostics instead of
+    // going to handler.on_error. With a plain ini_handler this only validates
+    bool parse(ini_handler& handler, std::vector<parse_diagnostic>& diagnostics);
+
+    // parses the file into the arena backed document model instead
+    arena_ini_file parse_arena();
+
+    // parses the same file into the same ini_file as parse(), but splits the
+    // input at sections that start a line into up to threads pieces (0 means
+    // one per core) and parses them on thread_pool::shared(). Pieces are at least
+    // min_chunk_size bytes, so small files are simply parsed by parse().
+    // The whole file is mapped for the parse even in buffered mode, entries
+    // only borrow from it in mapped mode. Buffers are split as they are, and
+    // streams and descriptors are parsed by parse()
+    ini_file parse_parallel(unsigned threads = 0, std::size_t min_chunk_size = 256 * 1024);
+
     // accessor method for the filename field
     [[nodiscard]] std::string const& get_filename() const noexcept;
 
+    // true once the parser is made, a file that cannot be opened throws
+    // std::system_error from the constructor in every input mode
+    [[nodiscard]] bool is_open() const;
+
+    // how long the parse waited on reads so far, all zero unless reading ahead
+    [[nodiscard]] read_ahead_stats io_stats() const;
+
+    // stores the keys of parsed entries in pool instead of in every entry.
+    // Files parsed this way retain the pool, so it can be shared by a batch
+    void use_string_pool(std::shared_ptr<string_pool> shared_pool);
+
     // default destructor
     ~ini_parser();
 
 };
 
+// splits text into at most parts pieces of about equal size. Every piece but
+// the first starts with a '[' at the start of a line. With parts == 0 text is
+// split before every such '['
+std::vector<std::string_view> split_at_sections(std::string_view text, char line_separator, std::size_t parts);
+
 }  // namespace tom
 
 #endif  // PARSEINI_INI_PARSER_H
@@ -0,0 +1,223 @@
+#ifndef PARSEINI_INI_SCHEMA_H
+#define PARSEINI_INI_SCHEMA_H
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ini_entry.h"
+#include "ini_handler.h"
+#include "ini_parser.h"
+#include "utils.h"
+#include "value_conversion.h"
+
+namespace tom {
+
+namespace detail {
+
+// field hashes are worked out at compile time, a section's state is reused
+// for every key in it
+constexpr std::uint64_t section_state(std::string_view section) noexcept {
+    // the ']' keeps "ab" + "c" apart from "a" + "bc"
+    return fnv_append(fnv_append(fnv_offset, section), "]");
+}
+
+}  // namespace detail
+
+// marks a field without a default, see required()
+struct no_default_t { };
+
+// binds the value of key in section to member of Struct
+template <typename Struct, typename T, typename Default>
+struct schema_field {
+    using struct_type = Struct;
+    using value_type  = T;
+
+    static constexpr bool is_required = std::is_same_v<Default, no_default_t>;
+
+    std::string_view section;
+    std::string_view key;
+    T Struct::*      member;
+    Default          fallback;
+    std::uint64_t    hash;
+};
+
+// a field given fallback when the file does not have it
+template <typename Struct, typename T, typename Default>
+constexpr schema_field<Struct, T, Default> field(
+    std::string_view section, std::string_view key, T Struct::* member, Default fallback
+) {
+    return {section, key, member, fallback, fnv_append(detail::section_state(section), key)};
+}
+
+// a field reported as missing when the file does not have it
+template <typename Struct, typename T>
+constexpr schema_field<Struct, T, no_default_t> required(
+    std::string_view section, std::string_view key, T Struct::* member
+) {
+    return {section, key, member, no_default_t{ }, fnv_append(detail::section_state(section), key)};
+}
+
+// the sections, keys, types and defaults of Struct, see make_schema
+template <typename Struct, typename... Fields>
+struct ini_schema {
+    std::tuple<Fields...> fields;
+};
+
+// declares a schema, constexpr when the defaults are literals. Two fields for
+// the same key are an error, at compile time for a constexpr schema
+template <typename First, typename... Rest>
+constexpr ini_schema<typename First::struct_type, First, Rest...> make_schema(First first, Rest... rest) {
+    static_assert((std::is_same_v<typename First::struct_type, typename Rest::struct_type> && ...),
+                  "Every field of a schema must bind to the same struct");
+
+    std::array<std::uint64_t, 1 + sizeof...(Rest)> const hashes{first.hash, rest.hash...};
+    std::array<std::string_view, 1 + sizeof...(Rest)> const sections{first.section, rest.section...};
+    std::array<std::string_view, 1 + sizeof...(Rest)> const keys{first.key, rest.key...};
+    for (std::size_t i = 0; i < hashes.size(); i++)
+        for (std::size_t j = i + 1; j < hashes.size(); j++)
+            if (hashes[i] == hashes[j] && sections[i] == sections[j] && keys[i] == keys[j])
+                throw std::logic_error("Schema declares a key twice");
+
+    return {std::tuple<First, Rest...>{first, rest...}};
+}
+
+// what parse_into could not bind
+struct schema_report {
+    struct issue {
+        std::string section;
+        std::string key;
+    };
+
+    // entries of the file that no field asks for
+    std::vector<issue> unknown;
+    // required fields the file does not have
+    std::vector<issue> missing;
+    // entries whose value could not be converted to the field's type. The
+    // member is given its default, if it has one
+    std::vector<issue> invalid;
+
+    [[nodiscard]] bool ok() const noexcept { return unknown.empty() && missing.empty() && invalid.empty(); }
+};
+
+namespace detail {
+
+template <typename T>
+bool assign_value(std::string_view text, T& out) {
+    if constexpr (is_convertible_value_v<T>) {
+        return convert_value(text, out) == std::errc{ };
+    } else if constexpr (std::is_assignable_v<T&, std::string_view>) {
+        out = text;
+        return true;
+    } else {
+        out = ini_entry::adapt_to<T>{ }(std::string{text});
+        return true;
+    }
+}
+
+template <typename Struct, typename... Fields>
+class schema_binder final : public ini_handler {
+    enum class state : unsigned char { unseen, bound, invalid };
+
+    ini_schema<Struct, Fields...> const& schema;
+    Struct&                              out;
+    schema_report&                       report;
+
+    std::string                          section{ };
+    std::uint64_t                        section_hash = section_state({ });
+    std::array<state, sizeof...(Fields)> states{ };
+
+    template <std::size_t I>
+    bool bind(std::uint64_t hash, std::string_view key, std::string_view value) {
+        auto const& field = std::get<I>(schema.fields);
+        if (field.hash != hash || field.key != key || field.section != section)
+            return false;
+
+        if (assign_value(value, out.*field.member)) {
+            states[I] = state::bound;
+        } else {
+            states[I] = state::invalid;
+            report.invalid.push_back(schema_report::issue{section, std::string{key}});
+        }
+        return true;
+    }
+
+    template <std::size_t... I>
+    bool bind_any(std::uint64_t hash, std::string_view key, std::string_view value, std::index_sequence<I...>) {
+        return (bind<I>(hash, key, value) || ...);
+    }
+
+    template <std::size_t... I>
+    void finish(std::index_sequence<I...>) {
+        (finish_field<I>(), ...);
+    }
+
+    template <std::size_t I>
+    void finish_field() {
+        auto const& field = std::get<I>(schema.fields);
+        if (states[I] == state::bound)
+            return;
+
+        if constexpr (!std::remove_reference_t<decltype(field)>::is_required)
+            out.*field.member = field.fallback;
+        else if (states[I] == state::unseen)
+            report.missing.push_back(schema_report::issue{std::string{field.section}, std::string{field.key}});
+    }
+
+    template <std::size_t... I>
+    void forget_section(std::index_sequence<I...>) {
+        ((std::get<I>(schema.fields).section == section ? void(states[I] = state::unseen) : void()), ...);
+    }
+
+public:
+    schema_binder(ini_schema<Struct, Fields...> const& schema, Struct& out, schema_report& report) :
+        schema(schema), out(out), report(report) { }
+
+    bool on_section(std::string_view name) override {
+        section.assign(name);
+        section_hash = section_state(name);
+
+        // a section that appears again replaces the earlier one, as in parse(),
+        // and what was found wrong with it no longer applies
+        forget_section(std::index_sequence_for<Fields...>{ });
+        auto const in_section = [name](schema_report::issue const& each) { return each.section == name; };
+        std::erase_if(report.unknown, in_section);
+        std::erase_if(report.invalid, in_section);
+        return true;
+    }
+
+    bool on_entry(std::string_view key, std::string_view value) override {
+        if (!bind_any(fnv_append(section_hash, key), key, value, std::index_sequence_for<Fields...>{ }))
+            report.unknown.push_back(schema_report::issue{section, std::string{key}});
+        return true;
+    }
+
+    void finish() {
+        finish(std::index_sequence_for<Fields...>{ });
+    }
+};
+
+}  // namespace detail
+
+// parses the file straight into out, converting each value to the type of
+// the member it is bound to. Nothing else is kept. As in parse(), later values
+// for a key win and a section that appears twice replaces the first one.
+// Members whose key the file does not have get their default. Sections are
+// named as parse() names them. Throws parse_error like parse() does
+template <typename Struct, typename... Fields>
+schema_report parse_into(ini_parser& parser, ini_schema<Struct, Fields...> const& schema, Struct& out) {
+    schema_report                              report{ };
+    detail::schema_binder<Struct, Fields...> binder{schema, out, report};
+    parser.parse(binder);
+    binder.finish();
+    return report;
+}
+
+}  // namespace tom
+
+#endif  // PARSEINI_INI_SCHEMA_H
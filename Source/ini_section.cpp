@@ -4,68 +4,150 @@
 
 #include "ini_section.h"
 #include "ini_entry.h"
+#include "ini_file.h"
 
 namespace tom {
 
+void ini_section::hold(view_map<std::shared_ptr<ini_entry>> const& entries) noexcept {
+    for (auto const& [key, entry] : entries)
+        entry->sections_holding_++;
+}
+
+void ini_section::release(view_map<std::shared_ptr<ini_entry>> const& entries) noexcept {
+    for (auto const& [key, entry] : entries)
+        entry->sections_holding_--;
+}
+
 ini_section::ini_section(std::weak_ptr<ini_file> owner, std::weak_ptr<ini_section> parent, std::string name) :
-    owner(std::move(owner)), parent(std::move(parent)), name(std::move(name)) { }
+    name(std::move(name)), parent(std::move(parent)), owner(std::move(owner)) { }
 
-ini_section::ini_section(ini_section const& other) = default;
-ini_section::ini_section(ini_section&& other) noexcept = default;
+// copies are not part of any file until they are added to one
+ini_section::ini_section(ini_section const& other) :
+    std::enable_shared_from_this<ini_section>(), emap(other.emap), next_entry_order(other.next_entry_order),
+    name(other.name), parent(other.parent), owner(other.owner) {
+    hold(emap);
+}
+
+ini_section::ini_section(ini_section&& other) noexcept {
+    // other leaves its file's index while it still has the entries and the
+    // name the index was built from
+    if (other.index_owner != nullptr)
+        other.index_owner->unindex_section(&other);
+    emap             = std::move(other.emap);
+    other.emap.clear();
+    next_entry_order = other.next_entry_order;
+    name             = std::move(other.name);
+    parent           = std::move(other.parent);
+    owner            = std::move(other.owner);
+}
 
 ini_section& ini_section::operator =(ini_section const& other) {
     if (&other != this) {
+        auto* file = index_owner;
+        if (file != nullptr)
+            file->unindex_section(this);
+        release(emap);
         name   = other.name;
         owner  = other.owner;
         parent = other.parent;
         emap   = other.emap;
+        hold(emap);
         dirty  = true;
+        next_entry_order = other.next_entry_order;
+        if (file != nullptr)
+            file->index_section(this);
     }
     return *this;
 }
 
 ini_section& ini_section::operator =(ini_section&& other) noexcept {
     if (&other != this) {
+        auto* file = index_owner;
+        if (file != nullptr)
+            file->unindex_section(this);
+        if (other.index_owner != nullptr)
+            other.index_owner->unindex_section(&other);
+        release(emap);
         name   = std::move(other.name);
         owner  = std::move(other.owner);
         parent = std::move(other.parent);
         emap   = std::move(other.emap);
+        other.emap.clear();
         dirty  = true;
+        next_entry_order = other.next_entry_order;
+        if (file != nullptr)
+            file->index_section(this);
     }
     return *this;
 }
 
 bool ini_section::add_entry(std::string const& key, std::string const& value) {
     //  dirty = true; // unnecessary becasue we call add_entry()
+    if (auto* pool = index_owner != nullptr ? index_owner->pool.get() : nullptr)
+        return add_entry(std::make_shared<ini_entry>(this->weak_from_this(), pool->intern(key), value,
+                                                     ini_entry::borrowed_key));
     auto entry = std::make_shared<ini_entry>(this->weak_from_this(), key, value);
     return add_entry(entry);
 }
 
 bool ini_section::add_entry(std::shared_ptr<ini_entry> const& entry) {
     dirty = true;
-    auto const& key = entry->key();
-    auto result = false;
-    if (emap.find(key) != emap.end())
-        result = true;
-
-    emap[key] = entry;
-    return result;
+    auto [it, inserted] = emap.try_emplace(entry->key_view(), entry);
+    if (!inserted) {
+        // a replacement takes the place of the entry it replaces. The map key
+        // and the file's index view the old entry's key, they are moved over
+        // to the new entry's before the old one is released
+        auto const replaced     = it->second;
+        entry->insertion_order_ = replaced->insertion_order_;
+        auto const old_key      = it->first;
+        auto       node         = emap.extract(it);
+        node.key()              = entry->key_view();
+        node.mapped()           = entry;
+        emap.insert(std::move(node));
+        replaced->sections_holding_--;
+        entry->sections_holding_++;
+        if (index_owner != nullptr)
+            index_owner->repoint_key(old_key, entry->key_view());
+        return true;
+    }
+    entry->sections_holding_++;
+    entry->insertion_order_ = next_entry_order++;
+    if (index_owner != nullptr)
+        index_owner->index_key(entry->key_view(), this);
+    return false;
 }
 
-bool ini_section::remove_entry(std::string const& key) {
+bool ini_section::remove_entry(std::string_view key) {
     dirty = true;
-    auto v = (emap.erase(key) >= 1);
-    return v;
+    auto it = emap.find(key);
+    if (it == emap.end())
+        return false;
+    if (index_owner != nullptr)
+        index_owner->unindex_key(key, this);
+    it->second->sections_holding_--;
+    emap.erase(it);
+    return true;
+}
+
+std::shared_ptr<ini_entry> ini_section::get_entry(std::string_view key) const noexcept {
+    return get_or_nullptr(emap, key);
 }
 
-std::shared_ptr<ini_entry> ini_section::get_entry(std::string const& key) const noexcept {
+std::shared_ptr<ini_entry> ini_section::get_entry(ini_key const& key) const noexcept {
     return get_or_nullptr(emap, key);
 }
 
+std::shared_ptr<ini_entry> ini_section::get_inherited_entry(std::string_view key) const {
+    // a section outside any file has nothing above it
+    if (index_owner == nullptr)
+        return get_entry(key);
+    return index_owner->get_inherited_entry(name, key);
+}
+
 std::vector<std::weak_ptr<ini_entry>> const& ini_section::entries() const {
     if (dirty) {
         entry_cache = std::vector<std::weak_ptr<ini_entry>>{ };
-        std::for_each(std::begin(emap), std::end(emap), [this](auto a) {
+        std::for_each(std::begin(emap), std::end(emap), [this](auto const& a) {
             this->entry_cache.push_back(std::get<1>(a));
         });
         dirty = false;
@@ -73,7 +155,15 @@ std::vector<std::weak_ptr<ini_entry>> const& ini_section::entries() const {
     return entry_cache;
 }
 
-std::pair<std::string, bool> ini_section::get_value(std::string const& key) const {
+ini_section::entry_range ini_section::each_entry() {
+    return entry_range{emap.cbegin(), emap.cend(), emap.size()};
+}
+
+ini_section::const_entry_range ini_section::each_entry() const {
+    return const_entry_range{emap.cbegin(), emap.cend(), emap.size()};
+}
+
+std::pair<std::string, bool> ini_section::get_value(std::string_view key) const {
     auto entry = get_entry(key);
     if (entry == nullptr) {
         return std::pair<std::string, bool>{ "", false };
@@ -84,15 +174,30 @@ std::pair<std::string, bool> ini_section::get_value(std::string const& key) cons
 
 std::string const& ini_section::operator [](const std::string& key) {
     dirty = true; // unnecessary bc const ref return value
-    auto entry = get_or_nullptr(emap, key);
-    if (entry == nullptr) {
-        add_entry(key, "");
-        entry = get_or_nullptr(emap, key);
-    }
-    return entry->value();
+    if (auto it = emap.find(key); it != emap.end())
+        return it->second->own_value();
+
+    add_entry(key, "");
+    return get_or_nullptr(emap, key)->own_value();
 }
 
+memory_report ini_section::memory_usage() const {
+    memory_report report{ };
+    report.objects += detail::shared_object_bytes<ini_section>();
+    report.strings += detail::heap_bytes(name);
+
+    for (auto const& [key, entry] : emap) {
+        report.objects += detail::shared_object_bytes<ini_entry>();
+        // borrowed text lives elsewhere and leaves these empty
+        report.strings += detail::heap_bytes(entry->key_) + detail::heap_bytes(entry->value_);
+    }
+    detail::count_map(emap, report);
+    report.caches += detail::vector_bytes(entry_cache);
+    return report;
+}
 
-ini_section::~ini_section() = default;
+ini_section::~ini_section() {
+    release(emap);
+}
 
 }  // namespace tom
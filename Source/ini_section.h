@@ -6,11 +6,14 @@
 #define PARSEINI_INI_SECTION_H
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "memory_report.h"
+#include "utils.h"
 // #include "ini_entry.h"
 
 namespace tom {
@@ -20,11 +23,32 @@ struct ini_file;
 
 struct ini_section : std::enable_shared_from_this<ini_section> {
 private:
-    std::unordered_map<std::string, std::shared_ptr<ini_entry>> emap{ };
-    mutable std::vector<std::weak_ptr<ini_entry>>               entry_cache{ };
-    mutable bool                                                dirty = true;
+    // keyed by each entry's key_view(), so the key is stored once, by the
+    // entry (or the pool or mapping it borrows from)
+    view_map<std::shared_ptr<ini_entry>>          emap{ };
+    mutable std::vector<std::weak_ptr<ini_entry>> entry_cache{ };
+    mutable bool                                  dirty = true;
+
+    // the file whose key index lists this section, see ini_file::key_index
+    ini_file* index_owner = nullptr;
+
+    // when the section was added to its file, and the stamp the next new
+    // entry gets. Used to write entries back in the order they were added
+    std::uint64_t insertion_order = 0;
+    std::uint64_t next_entry_order = 0;
+
+    // entries count the sections holding them, see ini_entry::sections_holding_
+    static void hold(view_map<std::shared_ptr<ini_entry>> const& entries) noexcept;
+
+    static void release(view_map<std::shared_ptr<ini_entry>> const& entries) noexcept;
+
+    friend struct ini_file;
+    friend class ini_writer;
 
 public:
+    using entry_range       = pointee_range<view_map<std::shared_ptr<ini_entry>>::const_iterator, ini_entry>;
+    using const_entry_range = pointee_range<view_map<std::shared_ptr<ini_entry>>::const_iterator, ini_entry const>;
+
     std::string                name;
     std::weak_ptr<ini_section> parent;
     std::weak_ptr<ini_file>    owner;
@@ -39,26 +63,43 @@ public:
     ini_section& operator =(ini_section&& other) noexcept;
 
     // you must add entries using the add_entry method. NEVER directly manipulate
-    // the map or vector
+    // the map or vector. In a file with a string pool the key is stored in
+    // the pool. An entry's key must not be changed while it is in a section
     bool add_entry(std::string const& key, std::string const& value);
 
     bool add_entry(std::shared_ptr<ini_entry> const& entry);
 
     // you must remove entries using the add_entry method. NEVER directly
     // manipulate the map or vector
-    bool remove_entry(std::string const& key);
+    bool remove_entry(std::string_view key);
 
-    std::shared_ptr<ini_entry> get_entry(std::string const& key) const noexcept;
+    std::shared_ptr<ini_entry> get_entry(std::string_view key) const noexcept;
+
+    std::shared_ptr<ini_entry> get_entry(ini_key const& key) const noexcept;
+
+    // the entry for key here, or in the closest section above this one in its
+    // file's dotted hierarchy, see ini_file::get_inherited_entry
+    std::shared_ptr<ini_entry> get_inherited_entry(std::string_view key) const;
 
     std::vector<std::weak_ptr<ini_entry>> const& entries() const;
 
+    // iterates the entries in place without allocating or locking anything.
+    // Adding or removing entries invalidates the range
+    entry_range each_entry();
+
+    const_entry_range each_entry() const;
+
     // returns a pair of <value_, present>
     // If the key_ is present, then the second element is true
     // If the key_ is not present, then value_ == "" and present == false
-    std::pair<std::string, bool> get_value(std::string const& key) const;
+    std::pair<std::string, bool> get_value(std::string_view key) const;
 
     std::string const& operator [](std::string const& key);
 
+    // heap bytes held by this section and its entries. Text borrowed from a
+    // mapping or a string pool is not counted
+    [[nodiscard]] memory_report memory_usage() const;
+
     ~ini_section();
 };
 
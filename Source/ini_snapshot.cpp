@@ -0,0 +1,373 @@
+#include "ini_snapshot.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <unordered_map>
+#include <sys/stat.h>
+#include "ini_entry.h"
+#include "ini_parser.h"
+#include "ini_section.h"
+#include "utils.h"
+
+namespace tom {
+
+namespace {
+
+constexpr char          snapshot_magic[8] = {'I', 'N', 'I', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t byte_order_mark   = 0x01020304;
+
+std::uint64_t name_hash(std::string_view name) noexcept {
+    return fnv_append(fnv_offset, name);
+}
+
+std::uint64_t entry_hash(std::uint32_t section, std::string_view key) noexcept {
+    return fnv_append(fnv_offset ^ (section * 0x9E3779B97F4A7C15ull), key);
+}
+
+// at most half full, so probes stay short and always end at an empty slot
+std::uint32_t slot_count_for(std::size_t count) {
+    return static_cast<std::uint32_t>(std::bit_ceil(std::max<std::size_t>(count * 2, 2)));
+}
+
+// slots hold a record index + 1, 0 marks an empty slot
+void insert_slot(std::vector<std::uint32_t>& slots, std::uint64_t hash, std::uint32_t index) {
+    std::size_t const mask = slots.size() - 1;
+    std::size_t       at   = hash & mask;
+    while (slots[at] != 0)
+        at = (at + 1) & mask;
+    slots[at] = index + 1;
+}
+
+// records is the size of the table the slots index. A damaged table may
+// hold indices past it or have no empty slot, neither is followed
+template <typename Matches>
+std::uint32_t find_slot(std::uint32_t const* slots, std::uint32_t count, std::uint32_t records, std::uint64_t hash,
+                        Matches matches) noexcept {
+    std::uint32_t const mask = count - 1;
+    std::uint32_t       at   = hash & mask;
+    for (std::uint32_t probes = 0; probes < count && slots[at] != 0; probes++, at = (at + 1) & mask)
+        if (slots[at] <= records && matches(slots[at] - 1))
+            return slots[at] - 1;
+    return std::numeric_limits<std::uint32_t>::max();
+}
+
+std::size_t align8(std::size_t offset) noexcept {
+    return (offset + 7) & ~std::size_t{7};
+}
+
+}  // namespace
+
+struct ini_snapshot::header {
+    char          magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t format_version;
+    std::uint64_t checksum;
+    std::uint64_t image_size;
+    std::uint64_t source_size;
+    std::int64_t  source_mtime_ns;
+
+    std::uint32_t section_count;
+    std::uint32_t entry_count;
+    std::uint32_t section_slot_count;
+    std::uint32_t entry_slot_count;
+    std::uint32_t key_slot_count;
+    std::uint32_t strings_size;
+
+    std::uint64_t sections_offset;
+    std::uint64_t entries_offset;
+    std::uint64_t section_slots_offset;
+    std::uint64_t entry_slots_offset;
+    std::uint64_t key_slots_offset;
+    std::uint64_t strings_offset;
+};
+
+struct ini_snapshot::section_record {
+    std::uint32_t name_offset;
+    std::uint32_t name_size;
+    std::uint32_t first_entry;
+    std::uint32_t entry_count;
+};
+
+struct ini_snapshot::entry_record {
+    std::uint32_t key_offset;
+    std::uint32_t key_size;
+    std::uint32_t value_offset;
+    std::uint32_t value_size;
+    std::uint32_t section;
+};
+
+source_stamp source_stamp::of(std::string const& path) {
+    struct stat st{ };
+    if (::stat(path.c_str(), &st) != 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot stat " + path);
+    return source_stamp{static_cast<std::uint64_t>(st.st_size),
+                        static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec};
+}
+
+void ini_snapshot::write(ini_file const& file, std::string const& path, source_stamp source) {
+    std::vector<section_record>                     section_records{ };
+    std::vector<entry_record>                       entry_records{ };
+    std::string                                     string_table{ };
+    std::unordered_map<std::string_view, std::uint32_t> string_offsets{ };
+    std::unordered_map<ini_entry const*, std::uint32_t> entry_indices{ };
+
+    // equal strings are stored once
+    auto const store = [&string_table, &string_offsets](std::string_view text) {
+        auto [it, inserted] = string_offsets.try_emplace(text, static_cast<std::uint32_t>(string_table.size()));
+        if (inserted)
+            string_table.append(text);
+        return it->second;
+    };
+
+    for (auto const& section : file.each_section()) {
+        auto const index = static_cast<std::uint32_t>(section_records.size());
+        section_records.push_back(section_record{store(section.name), static_cast<std::uint32_t>(section.name.size()),
+                                                 static_cast<std::uint32_t>(entry_records.size()), 0});
+        for (auto const& entry : section.each_entry()) {
+            entry_indices.emplace(&entry, static_cast<std::uint32_t>(entry_records.size()));
+            entry_records.push_back(entry_record{store(entry.key_view()),
+                                                 static_cast<std::uint32_t>(entry.key_view().size()),
+                                                 store(entry.value_view()),
+                                                 static_cast<std::uint32_t>(entry.value_view().size()),
+                                                 index});
+            section_records.back().entry_count++;
+        }
+    }
+
+    std::vector<std::uint32_t> section_slots(slot_count_for(section_records.size()), 0);
+    for (std::uint32_t i = 0; i < section_records.size(); i++)
+        insert_slot(section_slots, name_hash(string_table.substr(section_records[i].name_offset,
+                                                                 section_records[i].name_size)), i);
+
+    // every key also points at the entry the file's own key index finds first
+    std::vector<std::uint32_t> entry_slots(slot_count_for(entry_records.size()), 0);
+    std::vector<std::uint32_t> key_slots(slot_count_for(entry_records.size()), 0);
+    std::vector<bool>          key_done(entry_records.size(), false);
+    for (std::uint32_t i = 0; i < entry_records.size(); i++) {
+        auto const& record = entry_records[i];
+        std::string_view const key{string_table.data() + record.key_offset, record.key_size};
+        insert_slot(entry_slots, entry_hash(record.section, key), i);
+
+        if (auto first = file.get_entry(key)) {
+            auto const found = entry_indices.at(first.get());
+            if (!key_done[found]) {
+                key_done[found] = true;
+                insert_slot(key_slots, name_hash(key), found);
+            }
+        }
+    }
+
+    header head{ };
+    std::memcpy(head.magic, snapshot_magic, sizeof snapshot_magic);
+    head.byte_order         = byte_order_mark;
+    head.format_version     = version;
+    head.source_size        = source.size;
+    head.source_mtime_ns    = source.mtime_ns;
+    head.section_count      = static_cast<std::uint32_t>(section_records.size());
+    head.entry_count        = static_cast<std::uint32_t>(entry_records.size());
+    head.section_slot_count = static_cast<std::uint32_t>(section_slots.size());
+    head.entry_slot_count   = static_cast<std::uint32_t>(entry_slots.size());
+    head.key_slot_count     = static_cast<std::uint32_t>(key_slots.size());
+    head.strings_size       = static_cast<std::uint32_t>(string_table.size());
+
+    std::string image(align8(sizeof(header)), '\0');
+    auto const  append = [&image](void const* data, std::size_t size) {
+        image.resize(align8(image.size()), '\0');
+        auto const offset = image.size();
+        image.append(static_cast<char const*>(data), size);
+        return offset;
+    };
+    head.sections_offset      = append(section_records.data(), section_records.size() * sizeof(section_record));
+    head.entries_offset       = append(entry_records.data(), entry_records.size() * sizeof(entry_record));
+    head.section_slots_offset = append(section_slots.data(), section_slots.size() * sizeof(std::uint32_t));
+    head.entry_slots_offset   = append(entry_slots.data(), entry_slots.size() * sizeof(std::uint32_t));
+    head.key_slots_offset     = append(key_slots.data(), key_slots.size() * sizeof(std::uint32_t));
+    head.strings_offset       = append(string_table.data(), string_table.size());
+    head.image_size           = image.size();
+    head.checksum = fnv_append(fnv_offset, std::string_view{image}.substr(sizeof(header)));
+    std::memcpy(image.data(), &head, sizeof head);
+
+    std::string const temporary = path + ".tmp";
+    {
+        std::ofstream out{temporary, std::ios::binary | std::ios::trunc};
+        out.write(image.data(), static_cast<std::streamsize>(image.size()));
+        out.close();
+        if (!out)
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + temporary);
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot replace " + path);
+}
+
+ini_snapshot::ini_snapshot(std::string path, bool verify) : image(std::move(path)) {
+    auto const fail = [this](char const* why) {
+        throw snapshot_error(image.get_filename() + ": " + why);
+    };
+
+    if (image.size() < sizeof(header))
+        fail("not a snapshot");
+
+    head = reinterpret_cast<header const*>(image.data());
+    if (std::memcmp(head->magic, snapshot_magic, sizeof snapshot_magic) != 0)
+        fail("not a snapshot");
+    if (head->byte_order != byte_order_mark)
+        fail("written with another byte order");
+    if (head->format_version != version)
+        fail("written by another version");
+    if (head->image_size != image.size())
+        fail("truncated");
+
+    auto const table_fits = [this](std::uint64_t offset, std::uint64_t count, std::size_t size) {
+        return offset % 4 == 0 && offset <= image.size() && count <= (image.size() - offset) / size;
+    };
+    auto const slots_valid = [](std::uint32_t count) { return count != 0 && std::has_single_bit(count); };
+    if (!table_fits(head->sections_offset, head->section_count, sizeof(section_record))
+        || !table_fits(head->entries_offset, head->entry_count, sizeof(entry_record))
+        || !table_fits(head->section_slots_offset, head->section_slot_count, sizeof(std::uint32_t))
+        || !table_fits(head->entry_slots_offset, head->entry_slot_count, sizeof(std::uint32_t))
+        || !table_fits(head->key_slots_offset, head->key_slot_count, sizeof(std::uint32_t))
+        || !table_fits(head->strings_offset, head->strings_size, 1)
+        || !slots_valid(head->section_slot_count) || !slots_valid(head->entry_slot_count)
+        || !slots_valid(head->key_slot_count))
+        fail("damaged");
+
+    if (verify && fnv_append(fnv_offset, image.view().substr(sizeof(header))) != head->checksum)
+        fail("checksum mismatch");
+
+    sections      = reinterpret_cast<section_record const*>(image.data() + head->sections_offset);
+    entries       = reinterpret_cast<entry_record const*>(image.data() + head->entries_offset);
+    section_slots = reinterpret_cast<std::uint32_t const*>(image.data() + head->section_slots_offset);
+    entry_slots   = reinterpret_cast<std::uint32_t const*>(image.data() + head->entry_slots_offset);
+    key_slots     = reinterpret_cast<std::uint32_t const*>(image.data() + head->key_slots_offset);
+    strings       = image.data() + head->strings_offset;
+}
+
+ini_snapshot ini_snapshot::load_or_build(
+    std::string const& source, std::string const& snapshot_path, std::vector<char> comment_chars, char line_separator
+) {
+    // stamped before parsing, a change made during the parse then makes the
+    // snapshot stale rather than silently missing from it
+    auto const stamp = source_stamp::of(source);
+
+    // the stamp says the image was built from this source, the checksum pass
+    // over all of it is left out so loading takes the same time at any size
+    try {
+        ini_snapshot existing{snapshot_path, false};
+        if (existing.stamp() == stamp)
+            return existing;
+    } catch (snapshot_error const&) {
+    } catch (std::system_error const&) {
+    }
+
+    ini_parser parser{source, std::move(comment_chars), line_separator};
+    write(parser.parse(), snapshot_path, stamp);
+    return ini_snapshot{snapshot_path, false};
+}
+
+bool ini_snapshot::matches(std::string const& source) const {
+    return source_stamp::of(source) == stamp();
+}
+
+source_stamp ini_snapshot::stamp() const noexcept {
+    return source_stamp{head->source_size, head->source_mtime_ns};
+}
+
+std::string_view ini_snapshot::string_at(std::uint32_t offset, std::uint32_t size) const noexcept {
+    // only the table's extent is checked on loading, a string outside it
+    // reads as empty
+    if (offset > head->strings_size || size > head->strings_size - offset)
+        return { };
+    return std::string_view{strings + offset, size};
+}
+
+ini_snapshot::section_record const* ini_snapshot::section_at_index(std::uint32_t index) const noexcept {
+    return index < head->section_count ? sections + index : nullptr;
+}
+
+ini_snapshot::entry_record const* ini_snapshot::entry_at_index(std::uint32_t index) const noexcept {
+    return index < head->entry_count ? entries + index : nullptr;
+}
+
+ini_snapshot::section_handle ini_snapshot::get_section(std::string_view name) const noexcept {
+    return section_handle{find_slot(section_slots, head->section_slot_count, head->section_count, name_hash(name),
+                                    [this, name](auto i) {
+        return string_at(sections[i].name_offset, sections[i].name_size) == name;
+    })};
+}
+
+ini_snapshot::entry_handle ini_snapshot::get_entry(section_handle section, std::string_view key) const noexcept {
+    if (!section)
+        return entry_handle{ };
+    return entry_handle{find_slot(entry_slots, head->entry_slot_count, head->entry_count, entry_hash(section.index, key),
+                                  [this, section, key](auto i) {
+        return entries[i].section == section.index && string_at(entries[i].key_offset, entries[i].key_size) == key;
+    })};
+}
+
+ini_snapshot::entry_handle ini_snapshot::get_entry(std::string_view key) const noexcept {
+    return entry_handle{find_slot(key_slots, head->key_slot_count, head->entry_count, name_hash(key),
+                                  [this, key](auto i) {
+        return string_at(entries[i].key_offset, entries[i].key_size) == key;
+    })};
+}
+
+std::optional<std::string_view> ini_snapshot::get_value(std::string_view section, std::string_view key) const noexcept {
+    if (auto entry = get_entry(get_section(section), key))
+        return value(entry);
+    return std::nullopt;
+}
+
+std::string_view ini_snapshot::section_name(section_handle section) const noexcept {
+    auto const* record = section_at_index(section.index);
+    return record == nullptr ? std::string_view{ } : string_at(record->name_offset, record->name_size);
+}
+
+std::string_view ini_snapshot::key(entry_handle entry) const noexcept {
+    auto const* record = entry_at_index(entry.index);
+    return record == nullptr ? std::string_view{ } : string_at(record->key_offset, record->key_size);
+}
+
+std::string_view ini_snapshot::value(entry_handle entry) const noexcept {
+    auto const* record = entry_at_index(entry.index);
+    return record == nullptr ? std::string_view{ } : string_at(record->value_offset, record->value_size);
+}
+
+ini_snapshot::section_handle ini_snapshot::section_of(entry_handle entry) const noexcept {
+    auto const* record = entry_at_index(entry.index);
+    if (record == nullptr || record->section >= head->section_count)
+        return section_handle{ };
+    return section_handle{record->section};
+}
+
+std::uint32_t ini_snapshot::section_count() const noexcept {
+    return head->section_count;
+}
+
+ini_snapshot::section_handle ini_snapshot::section_at(std::uint32_t index) const noexcept {
+    return index < head->section_count ? section_handle{index} : section_handle{ };
+}
+
+std::uint32_t ini_snapshot::entry_count(section_handle section) const noexcept {
+    // the section's entries must lie within the entry table
+    auto const* record = section_at_index(section.index);
+    if (record == nullptr || record->first_entry > head->entry_count)
+        return 0;
+    return std::min(record->entry_count, head->entry_count - record->first_entry);
+}
+
+ini_snapshot::entry_handle ini_snapshot::entry_at(section_handle section, std::uint32_t index) const noexcept {
+    if (index >= entry_count(section))
+        return entry_handle{ };
+    return entry_handle{sections[section.index].first_entry + index};
+}
+
+std::uint32_t ini_snapshot::entry_count() const noexcept {
+    return head->entry_count;
+}
+
+}  // namespace tom
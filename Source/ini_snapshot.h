@@ -0,0 +1,150 @@
+#ifndef PARSEINI_INI_SNAPSHOT_H
+#define PARSEINI_INI_SNAPSHOT_H
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ini_file.h"
+#include "mapped_file.h"
+
+namespace tom {
+
+// a snapshot that is not usable: not a snapshot, another version or damaged
+class snapshot_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// the size and modification time of a snapshot's source file, a snapshot is
+// stale once they change
+struct source_stamp {
+    std::uint64_t size     = 0;
+    std::int64_t  mtime_ns = 0;
+
+    // throws std::system_error if path cannot be stat'ed
+    static source_stamp of(std::string const& path);
+
+    bool operator ==(source_stamp const& other) const noexcept = default;
+};
+
+// a compiled ini_file that is mapped into memory and read in place. Lookups
+// hash into tables stored in the image and return views of its string table,
+// so loading parses nothing and looking up allocates nothing.
+//
+// The image is a header followed by the section and entry records, the two
+// hash tables and the string table. Everything is addressed by its offset
+// from the start of the image, so it can be mapped anywhere. Numbers are
+// stored in the byte order of the machine that wrote them, which the header
+// records along with a version and a checksum of everything after it
+class ini_snapshot {
+public:
+    static constexpr std::uint32_t version = 1;
+
+    struct section_handle {
+        static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t index = npos;
+
+        explicit operator bool() const noexcept { return index != npos; }
+    };
+
+    struct entry_handle {
+        static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t index = npos;
+
+        explicit operator bool() const noexcept { return index != npos; }
+    };
+
+    struct header;
+    struct section_record;
+    struct entry_record;
+
+private:
+    mapped_file image;
+
+    header const*         head     = nullptr;
+    section_record const* sections = nullptr;
+    entry_record const*   entries  = nullptr;
+    std::uint32_t const*  section_slots = nullptr;
+    std::uint32_t const*  entry_slots   = nullptr;
+    std::uint32_t const*  key_slots     = nullptr;
+    char const*           strings       = nullptr;
+
+    // records, strings and slots are checked against their tables as they
+    // are read rather than all of them on loading
+    std::string_view string_at(std::uint32_t offset, std::uint32_t size) const noexcept;
+
+    section_record const* section_at_index(std::uint32_t index) const noexcept;
+
+    entry_record const* entry_at_index(std::uint32_t index) const noexcept;
+
+public:
+    // maps and checks the image at path. Throws std::system_error if it
+    // cannot be mapped and snapshot_error if it is not a usable snapshot. The
+    // checksum needs a pass over the whole image, without verify only the
+    // header and table bounds are checked. Either way nothing is read outside
+    // the image, a damaged one that passes gives empty or wrong answers
+    explicit ini_snapshot(std::string path, bool verify = true);
+
+    // writes file as a snapshot image to path, stamped with the size and
+    // modification time its source had. The image is written next to path
+    // and renamed over it, so readers never see half of it
+    static void write(ini_file const& file, std::string const& path, source_stamp source);
+
+    // loads the snapshot at snapshot_path if it is usable and was built from
+    // source as it is now. Otherwise parses source, writes a new snapshot and
+    // loads that. The checksum is not verified, so loading does not read the
+    // whole image, construct one with verify to check it
+    static ini_snapshot load_or_build(
+        std::string const& source,
+        std::string const& snapshot_path,
+        std::vector<char> comment_chars = {'#', ';'},
+        char line_separator = '\n'
+    );
+
+    // true if the source's size and modification time are still those the
+    // snapshot was built from
+    [[nodiscard]] bool matches(std::string const& source) const;
+
+    [[nodiscard]] source_stamp stamp() const noexcept;
+
+    [[nodiscard]] section_handle get_section(std::string_view name) const noexcept;
+
+    [[nodiscard]] entry_handle get_entry(section_handle section, std::string_view key) const noexcept;
+
+    // the entry ini_file::get_entry(key) would find
+    [[nodiscard]] entry_handle get_entry(std::string_view key) const noexcept;
+
+    [[nodiscard]] std::optional<std::string_view> get_value(
+        std::string_view section, std::string_view key
+    ) const noexcept;
+
+    [[nodiscard]] std::string_view section_name(section_handle section) const noexcept;
+
+    [[nodiscard]] std::string_view key(entry_handle entry) const noexcept;
+
+    [[nodiscard]] std::string_view value(entry_handle entry) const noexcept;
+
+    [[nodiscard]] section_handle section_of(entry_handle entry) const noexcept;
+
+    // sections are numbered 0 to section_count() - 1, the entries of each
+    // section 0 to entry_count(section) - 1
+    [[nodiscard]] std::uint32_t section_count() const noexcept;
+
+    [[nodiscard]] section_handle section_at(std::uint32_t index) const noexcept;
+
+    [[nodiscard]] std::uint32_t entry_count(section_handle section) const noexcept;
+
+    [[nodiscard]] entry_handle entry_at(section_handle section, std::uint32_t index) const noexcept;
+
+    [[nodiscard]] std::uint32_t entry_count() const noexcept;
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_INI_SNAPSHOT_H
@@ -0,0 +1,271 @@
+#include "ini_watcher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ini_handler.h"
+#include "ini_parser.h"
+#include "parse_error.h"
+
+namespace tom {
+
+ini_watcher::ini_watcher(std::string filename_, std::vector<char> comment_chars_, char line_separator_) :
+    filename(std::move(filename_)),
+    basename(std::filesystem::path(filename).filename().string()),
+    comment_chars(std::move(comment_chars_)),
+    line_separator(line_separator_) {
+    auto directory = std::filesystem::path(filename).parent_path().string();
+    if (directory.empty())
+        directory = ".";
+
+    inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot start watching " + filename);
+
+    if (::inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        int const error = errno;
+        ::close(inotify_fd);
+        throw std::system_error(error, std::generic_category(), "Cannot watch " + directory);
+    }
+
+    try {
+        reload();
+    } catch (...) {
+        ::close(inotify_fd);
+        throw;
+    }
+}
+
+std::vector<std::shared_ptr<ini_watcher::parsed_section const>> ini_watcher::parse_piece(std::string_view text) const {
+    struct collector final : ini_handler {
+        std::vector<std::shared_ptr<parsed_section const>> sections{ };
+        parsed_section*                                    last = nullptr;
+
+        bool on_section(std::string_view name) override {
+            auto section = std::make_shared<parsed_section>(parsed_section{std::string{name}, { }});
+            last = section.get();
+            sections.push_back(std::move(section));
+            return true;
+        }
+
+        bool on_entry(std::string_view key, std::string_view value) override {
+            last->entries.insert_or_assign(std::string{key}, std::string{value});
+            return true;
+        }
+    } handler;
+
+    ini_parser parser{filename, text, nullptr, comment_chars, line_separator};
+    parser.parse(handler);
+    return std::move(handler.sections);
+}
+
+std::string ini_watcher::read_file() const {
+    int const fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + filename);
+
+    std::string text{ };
+    char        buffer[1 << 16];
+    for (;;) {
+        auto const n = ::read(fd, buffer, sizeof buffer);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) {
+            int const error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Cannot read " + filename);
+        }
+        if (n == 0)
+            break;
+        text.append(buffer, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+    return text;
+}
+
+namespace {
+
+void add_entries(std::vector<ini_change_set::entry_change>& changes, std::string const& section,
+                 std::map<std::string, std::string, std::less<>> const& entries) {
+    for (auto const& [key, value] : entries)
+        changes.push_back(ini_change_set::entry_change{section, key, value, { }});
+}
+
+}  // namespace
+
+ini_change_set ini_watcher::reload() {
+    std::string const      contents = read_file();
+    std::string_view const text     = contents;
+    auto const             parts    = split_at_sections(text, line_separator, 0);
+
+    std::unordered_multimap<std::size_t, std::size_t> old_by_hash{ };
+    for (std::size_t i = 0; i < pieces.size(); i++)
+        old_by_hash.emplace(pieces[i].hash, i);
+
+    // names whose section may have changed, in the order they were found
+    std::vector<std::string_view>                                  touched{ };
+    std::unordered_set<std::string_view, string_hash, string_equal> touched_set{ };
+    auto const touch = [&touched, &touched_set](piece const& each) {
+        for (auto const& section : each.sections)
+            if (touched_set.insert(section->name).second)
+                touched.push_back(section->name);
+    };
+
+    std::vector<bool>  reused(pieces.size(), false);
+    std::vector<piece> next{ };
+    std::size_t        parsed = 0;
+    next.reserve(parts.size());
+
+    for (auto part : parts) {
+        std::size_t const hash = std::hash<std::string_view>{ }(part);
+
+        auto [first, last] = old_by_hash.equal_range(hash);
+        auto same          = std::find_if(first, last, [this, &reused, part](auto const& candidate) {
+            return !reused[candidate.second] && pieces[candidate.second].text == part;
+        });
+        if (same != last) {
+            reused[same->second] = true;
+            next.push_back(pieces[same->second]);
+            continue;
+        }
+
+        try {
+            next.push_back(piece{hash, std::string{part}, parse_piece(part)});
+            touch(next.back());
+            parsed++;
+        } catch (parse_error const&) {
+            // parse it all as one piece, so the error thrown is the one for
+            // the whole file and its position counts from the file's start
+            next.clear();
+            next.push_back(piece{std::hash<std::string_view>{ }(text), contents, parse_piece(text)});
+            touch(next.back());
+            std::fill(reused.begin(), reused.end(), false);
+            parsed = 1;
+            break;
+        }
+    }
+
+    // the sections of pieces that are gone may have changed too
+    for (std::size_t i = 0; i < pieces.size(); i++)
+        if (!reused[i])
+            touch(pieces[i]);
+
+    // the section in effect for each touched name is the last one in the file
+    string_map<std::shared_ptr<parsed_section const>> effective{ };
+    for (auto const& each : next)
+        for (auto const& section : each.sections)
+            if (touched_set.find(section->name) != touched_set.end())
+                effective.insert_or_assign(section->name, section);
+
+    ini_change_set changes{ };
+    for (auto name : touched) {
+        auto const before = get_or_nullptr(current, name);
+        auto const after  = get_or_nullptr(effective, name);
+        if (before == after)
+            continue;
+
+        std::string const section{name};
+        if (before == nullptr) {
+            changes.added_sections.push_back(section);
+            add_entries(changes.added_entries, section, after->entries);
+            continue;
+        }
+        if (after == nullptr) {
+            changes.removed_sections.push_back(section);
+            continue;
+        }
+
+        // both maps are sorted by key, so one pass over them finds everything
+        std::size_t const count = changes.added_entries.size() + changes.removed_entries.size()
+                                  + changes.modified_entries.size();
+        auto old_it = before->entries.begin();
+        auto new_it = after->entries.begin();
+        while (old_it != before->entries.end() || new_it != after->entries.end()) {
+            if (new_it == after->entries.end() || (old_it != before->entries.end() && old_it->first < new_it->first)) {
+                changes.removed_entries.push_back(ini_change_set::entry_change{section, old_it->first, { }, old_it->second});
+                ++old_it;
+            } else if (old_it == before->entries.end() || new_it->first < old_it->first) {
+                changes.added_entries.push_back(ini_change_set::entry_change{section, new_it->first, new_it->second, { }});
+                ++new_it;
+            } else {
+                if (old_it->second != new_it->second)
+                    changes.modified_entries.push_back(
+                        ini_change_set::entry_change{section, new_it->first, new_it->second, old_it->second});
+                ++old_it;
+                ++new_it;
+            }
+        }
+        if (changes.added_entries.size() + changes.removed_entries.size() + changes.modified_entries.size() != count)
+            changes.modified_sections.push_back(section);
+    }
+
+    // touched names view into sections of the old pieces, so current is
+    // brought up to date before they are dropped
+    for (auto name : touched) {
+        if (auto it = effective.find(name); it != effective.end())
+            current.insert_or_assign(std::string{name}, it->second);
+        else if (auto gone = current.find(name); gone != current.end())
+            current.erase(gone);
+    }
+
+    pieces   = std::move(next);
+    reparsed = parsed;
+    return changes;
+}
+
+std::optional<ini_change_set> ini_watcher::wait(std::chrono::milliseconds timeout) {
+    using clock = std::chrono::steady_clock;
+    auto const deadline = clock::now() + timeout;
+
+    // events for other files in the directory do not end the wait
+    bool written = false;
+    while (!written) {
+        auto const left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+        pollfd     ready{inotify_fd, POLLIN, 0};
+        int const  count = ::poll(&ready, 1, static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0)));
+        if (count < 0 && errno != EINTR)
+            throw std::system_error(errno, std::generic_category(), "Cannot wait for " + filename);
+        if (count <= 0 && clock::now() >= deadline)
+            return std::nullopt;
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t                     length;
+        while ((length = ::read(inotify_fd, buffer, sizeof buffer)) > 0) {
+            for (char const* at = buffer; at < buffer + length;) {
+                auto const* event = reinterpret_cast<inotify_event const*>(at);
+                if (event->len > 0 && basename == event->name)
+                    written = true;
+                at += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+
+    return reload();
+}
+
+std::size_t ini_watcher::last_reparsed() const noexcept {
+    return reparsed;
+}
+
+int ini_watcher::native_handle() const noexcept {
+    return inotify_fd;
+}
+
+std::string const& ini_watcher::get_filename() const noexcept {
+    return filename;
+}
+
+ini_watcher::~ini_watcher() {
+    if (inotify_fd >= 0)
+        ::close(inotify_fd);
+}
+
+}  // namespace tom
@@ -0,0 +1,90 @@
+#ifndef PARSEINI_INI_WATCHER_H
+#define PARSEINI_INI_WATCHER_H
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ini_change_set.h"
+#include "utils.h"
+
+namespace tom {
+
+// watches an ini file with inotify and works out what changed each time it is
+// written. The file is cut into pieces at its section headers, and only the
+// pieces whose text changed since the last read are parsed again. The watch
+// is on the file's directory, so editors that save by replacing the file are
+// seen as well
+class ini_watcher {
+    using section_entries = std::map<std::string, std::string, std::less<>>;
+
+    struct parsed_section {
+        std::string     name;
+        section_entries entries;
+    };
+
+    // a piece is reused only if its text is the same, the hash just narrows
+    // down which pieces to compare
+    struct piece {
+        std::size_t                                        hash;
+        std::string                                        text;
+        std::vector<std::shared_ptr<parsed_section const>> sections;
+    };
+
+    std::string       filename;
+    std::string       basename;
+    std::vector<char> comment_chars;
+    char              line_separator;
+
+    int inotify_fd = -1;
+
+    // the file as last read, and the section in effect for every name, the
+    // last one in the file when a name appears more than once
+    std::vector<piece>                                 pieces{ };
+    string_map<std::shared_ptr<parsed_section const>> current{ };
+    std::size_t                                        reparsed = 0;
+
+    std::vector<std::shared_ptr<parsed_section const>> parse_piece(std::string_view text) const;
+
+    // the whole file, read rather than mapped as editors may truncate it
+    // while it is being parsed
+    [[nodiscard]] std::string read_file() const;
+
+public:
+    // reads the file and starts watching it. Throws std::system_error if it
+    // cannot be read or watched, and parse_error if it cannot be parsed
+    explicit ini_watcher(std::string filename, std::vector<char> comment_chars = {'#', ';'},
+                         char line_separator = '\n');
+
+    ini_watcher(ini_watcher const&) = delete;
+
+    ini_watcher& operator =(ini_watcher const&) = delete;
+
+    // waits up to timeout for the file to be written. Returns what changed
+    // since the last read, or nothing if it was not written in time. The
+    // change set is empty if it was written without changing anything
+    std::optional<ini_change_set> wait(std::chrono::milliseconds timeout);
+
+    // reads the file now and returns what changed since the last read. On a
+    // parse error the last read stays current and the error is thrown
+    ini_change_set reload();
+
+    // number of pieces the last read had to parse again
+    [[nodiscard]] std::size_t last_reparsed() const noexcept;
+
+    // the inotify descriptor, readable when the directory changed. For event
+    // loops that call wait(0) once it is
+    [[nodiscard]] int native_handle() const noexcept;
+
+    [[nodiscard]] std::string const& get_filename() const noexcept;
+
+    ~ini_watcher();
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_INI_WATCHER_H
@@ -0,0 +1,221 @@
+#include "ini_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ini_entry.h"
+#include "ini_file.h"
+#include "ini_section.h"
+
+namespace tom {
+
+namespace {
+
+#ifdef IOV_MAX
+constexpr std::size_t max_iovecs = IOV_MAX;
+#else
+constexpr std::size_t max_iovecs = 1024;
+#endif
+
+template <typename T, typename Key, typename Stamp>
+void sort_for(write_order order, std::vector<T const*>& items, Key key, Stamp stamp) {
+    if (order == write_order::sorted) {
+        std::sort(items.begin(), items.end(), [&](T const* a, T const* b) { return key(a) < key(b); });
+    } else if (order == write_order::insertion) {
+        // items shared between containers can carry the same stamp, the key
+        // keeps the order stable anyway
+        std::sort(items.begin(), items.end(), [&](T const* a, T const* b) {
+            return stamp(a) != stamp(b) ? stamp(a) < stamp(b) : key(a) < key(b);
+        });
+    }
+}
+
+}  // namespace
+
+ini_writer::ini_writer(int fd, write_options options_) :
+    fd(fd), options(options_), buffer(std::make_unique<char[]>(std::max<std::size_t>(options.buffer_size, 1))) {
+    options.buffer_size = std::max<std::size_t>(options.buffer_size, 1);
+}
+
+void ini_writer::append(std::string_view text) {
+    if (text.empty())
+        return;
+
+    if (pending.size() >= max_iovecs)
+        flush();
+
+    if (text.size() >= options.reference_threshold) {
+        pending.push_back(iovec{const_cast<char*>(text.data()), text.size()});
+        pending_bytes += text.size();
+        referencing = true;
+        return;
+    }
+
+    if (used + text.size() > options.buffer_size) {
+        flush();
+        // larger than the whole buffer, but under the reference threshold
+        if (text.size() > options.buffer_size) {
+            pending.push_back(iovec{const_cast<char*>(text.data()), text.size()});
+            pending_bytes += text.size();
+            flush();
+            return;
+        }
+    }
+
+    char* const target = buffer.get() + used;
+    std::memcpy(target, text.data(), text.size());
+    used += text.size();
+    pending_bytes += text.size();
+
+    // consecutive copies go out as one piece
+    if (!pending.empty() && static_cast<char*>(pending.back().iov_base) + pending.back().iov_len == target)
+        pending.back().iov_len += text.size();
+    else
+        pending.push_back(iovec{target, text.size()});
+}
+
+std::size_t write_gathered(int fd, iovec* pieces, std::size_t count) {
+    std::size_t calls = 0;
+    std::size_t first = 0;
+    while (first < count) {
+        auto const batch = static_cast<int>(std::min(count - first, max_iovecs));
+        ssize_t    done  = ::writev(fd, pieces + first, batch);
+        if (done < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "Cannot write ini file");
+        }
+        calls++;
+
+        // a short write leaves the rest of the pieces for the next call
+        while (first < count && static_cast<std::size_t>(done) >= pieces[first].iov_len)
+            done -= static_cast<ssize_t>(pieces[first++].iov_len);
+        if (first < count) {
+            pieces[first].iov_base = static_cast<char*>(pieces[first].iov_base) + done;
+            pieces[first].iov_len -= static_cast<std::size_t>(done);
+        }
+    }
+    return calls;
+}
+
+std::vector<ini_section const*> ini_writer::sections_in(ini_file const& file, write_order order) {
+    std::vector<ini_section const*> sections{ };
+    sections.reserve(file.each_section().size());
+    for (auto const& section : file.each_section())
+        sections.push_back(&section);
+    sort_for(order, sections, [](ini_section const* s) { return std::string_view{s->name}; },
+             [](ini_section const* s) { return s->insertion_order; });
+    return sections;
+}
+
+std::vector<ini_entry const*> ini_writer::entries_in(ini_section const& section, write_order order) {
+    std::vector<ini_entry const*> entries{ };
+    entries.reserve(section.each_entry().size());
+    for (auto const& entry : section.each_entry())
+        entries.push_back(&entry);
+    sort_for(order, entries, [](ini_entry const* e) { return e->key_view(); },
+             [](ini_entry const* e) { return e->insertion_order_; });
+    return entries;
+}
+
+void ini_writer::write_section(ini_section const& section) {
+    append("[");
+    append(section.name);
+    append("]\n");
+
+    auto const each_line = [this](ini_entry const& entry) {
+        append(entry.key_view());
+        append("=");
+        append(entry.value_view());
+        append("\n");
+    };
+
+    if (options.order == write_order::unordered) {
+        for (auto const& entry : section.each_entry())
+            each_line(entry);
+    } else {
+        for (auto const* entry : entries_in(section, options.order))
+            each_line(*entry);
+    }
+
+    append("\n");
+}
+
+void ini_writer::write(ini_file const& file) {
+    if (options.order == write_order::unordered) {
+        for (auto const& section : file.each_section())
+            write_section(section);
+    } else {
+        for (auto const* section : sections_in(file, options.order))
+            write_section(*section);
+    }
+
+    // the file may not outlive this call, strings it owns must be written now
+    if (referencing)
+        flush();
+}
+
+void ini_writer::flush() {
+    // a failed write drops what was pending, it is not retried by the next
+    auto pieces = std::move(pending);
+    auto bytes  = pending_bytes;
+    pending.clear();
+    pending_bytes = 0;
+    used          = 0;
+    referencing   = false;
+
+    calls += write_gathered(fd, pieces.data(), pieces.size());
+    written += bytes;
+
+    // keeps the capacity for the next round
+    pieces.clear();
+    pending = std::move(pieces);
+}
+
+std::size_t ini_writer::bytes_written() const noexcept {
+    return written;
+}
+
+std::size_t ini_writer::syscalls() const noexcept {
+    return calls;
+}
+
+void ini_writer::write_file(ini_file const& file, std::string const& path, write_options options) {
+    std::string const temporary = path + ".tmp";
+
+    int const fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + temporary);
+
+    try {
+        ini_writer writer{fd, options};
+        writer.write(file);
+        writer.flush();
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+
+    if (::close(fd) != 0) {
+        int const error = errno;
+        ::unlink(temporary.c_str());
+        throw std::system_error(error, std::generic_category(), "Cannot write " + temporary);
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot replace " + path);
+}
+
+ini_writer::~ini_writer() {
+    try {
+        flush();
+    } catch (std::system_error const&) {
+    }
+}
+
+}  // namespace tom
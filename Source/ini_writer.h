@@ -0,0 +1,99 @@
+#ifndef PARSEINI_INI_WRITER_H
+#define PARSEINI_INI_WRITER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/uio.h>
+
+namespace tom {
+
+struct ini_file;
+struct ini_section;
+
+enum class write_order {
+    // whatever order the hash maps hold, fastest but changes between runs
+    unordered,
+    // sections and entries in the order they were added. A replaced section
+    // or entry keeps the place of the one it replaced
+    insertion,
+    // sections by name, entries by key
+    sorted
+};
+
+struct write_options {
+    write_order order = write_order::insertion;
+    // bytes formatted before they are handed to the kernel
+    std::size_t buffer_size = 256 << 10;
+    // keys and values at least this long are written from where they are
+    // stored instead of being copied into the buffer
+    std::size_t reference_threshold = 512;
+};
+
+struct ini_entry;
+
+// writes count pieces to fd, retrying short writes and interrupted calls.
+// Pieces are advanced past what was written. Returns the number of writev
+// calls made, throws std::system_error
+std::size_t write_gathered(int fd, iovec* pieces, std::size_t count);
+
+// serializes ini_files into one large buffer and writes it to a file
+// descriptor with writev, in the same format as operator<<. Long keys and
+// values are not copied, the buffer and the strings themselves are gathered
+// by a single writev
+class ini_writer {
+    int                     fd;
+    write_options           options;
+    std::unique_ptr<char[]> buffer;
+    std::size_t             used = 0;
+    std::vector<iovec>      pending{ };
+    std::size_t             pending_bytes = 0;
+    // whether pending points at strings outside the buffer
+    bool                    referencing = false;
+
+    std::size_t written = 0;
+    std::size_t calls   = 0;
+
+    void append(std::string_view text);
+
+    void write_section(ini_section const& section);
+
+public:
+    explicit ini_writer(int fd, write_options options = { });
+
+    ini_writer(ini_writer const&) = delete;
+
+    ini_writer& operator =(ini_writer const&) = delete;
+
+    // formats the file and writes it out. What is left in the buffer when
+    // this returns is a copy, it is written by the next write or by flush
+    // and file may be destroyed in the meantime
+    void write(ini_file const& file);
+
+    // hands everything buffered to the kernel. Throws std::system_error
+    void flush();
+
+    // bytes handed to the kernel so far
+    [[nodiscard]] std::size_t bytes_written() const noexcept;
+
+    // writev calls made so far
+    [[nodiscard]] std::size_t syscalls() const noexcept;
+
+    // the sections of file and the entries of section in order
+    static std::vector<ini_section const*> sections_in(ini_file const& file, write_order order);
+
+    static std::vector<ini_entry const*> entries_in(ini_section const& section, write_order order);
+
+    // writes file to path through a temporary file that replaces path once
+    // it is complete, so readers never see half a file
+    static void write_file(ini_file const& file, std::string const& path, write_options options = { });
+
+    // flushes, errors are ignored, call flush first to see them
+    ~ini_writer();
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_INI_WRITER_H
@@ -5,20 +5,42 @@
 #ifndef PARSEINI_INISTREAM_H
 #define PARSEINI_INISTREAM_H
 
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <istream>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <array>
+#include <system_error>
+#include <tuple>
+#include <unistd.h>
+#include "read_ahead_reader.h"
 
 
 namespace tom {
 
 template <typename char_type = char, size_t buffer_size = 512>
 class inistream {
-    [[maybe_unused]] std::string                           filename;
+    std::string                                            filename;
     std::ifstream                                          input;
+    // a stream or descriptor owned by the caller, read instead of input
+    std::istream*                                          source = nullptr;
+    int                                                    fd     = -1;
+    // hands out blocks of the file read on another thread, used instead of buf
+    std::unique_ptr<read_ahead_reader>                     ahead{ };
     std::array<char_type, buffer_size>                     buf;
+    // the end of a read ahead block joined to the next block, while a token
+    // that starts at the end of one is looked at
+    std::basic_string<char_type>                           spill{ };
+    // the window being scanned. This is buf when reading from a file or the
+    // whole input when the stream was made over contiguous memory
+    char_type const*                                       data = nullptr;
     typename std::array<char_type, buffer_size>::size_type idx = 0;
-    typename std::array<char_type, buffer_size>::size_type max = buffer_size;
+    typename std::array<char_type, buffer_size>::size_type max = 0;
+    bool                                                   contiguous_ = false;
 
     // line separator
     char_type line_separator;
@@ -30,44 +52,190 @@ class inistream {
     int current_line_pos_ = 0;
     int current_pos_      = 0;
 
+    // reads up to n chars into at from the file, stream or descriptor, fewer
+    // only at the end
+    std::size_t read_into(char_type* at, std::size_t n) {
+        if (fd >= 0) {
+            // a short read is not the end of a pipe or socket, only 0 is
+            std::size_t got = 0;
+            while (got < n) {
+                auto const r = ::read(fd, at + got, (n - got) * sizeof(char_type));
+                if (r < 0 && errno == EINTR)
+                    continue;
+                if (r < 0)
+                    throw std::system_error(errno, std::generic_category(), "Cannot read " + filename);
+                if (r == 0)
+                    break;
+                got += static_cast<std::size_t>(r) / sizeof(char_type);
+            }
+            return got;
+        }
+
+        std::istream& from = source != nullptr ? *source : input;
+        from.read(at, static_cast<std::streamsize>(n));
+        return static_cast<std::size_t>(from.gcount());
+    }
+
     void read_data() {
-        input.read(buf.data(), buffer_size);
-        max = input.gcount();
+        // contiguous input is entirely in view already, there is nothing to refill
+        if (contiguous_)
+            return;
         idx = 0;
+
+        if (ahead != nullptr) {
+            auto const block = ahead->next();
+            data = block.data();
+            max  = block.size();
+            return;
+        }
+
+        data = buf.data();
+        max  = read_into(buf.data(), buffer_size);
     }
 
 public:
+    // opens filename. Throws std::system_error if it cannot be opened, like
+    // the mapped and read ahead modes do
     explicit inistream(std::string const& filename, char_type line_separator = '\n') :
         filename(filename), line_separator(line_separator) {
+        errno = 0;
         input = std::ifstream(filename);
+        if (!input.is_open())
+            throw std::system_error(errno != 0 ? errno : EIO, std::generic_category(), "Cannot open " + filename);
         read_data();
     }
 
-    [[nodiscard]] bool eof() const { return input.eof(); }
+    // reads from source, which must outlive the stream. name is only used in
+    // error messages
+    inistream(std::istream& source, std::string name, char_type line_separator = '\n') :
+        filename(std::move(name)), source(&source), line_separator(line_separator) {
+        read_data();
+    }
+
+    // reads from the open descriptor fd, which is not closed afterwards. name
+    // is only used in error messages
+    inistream(int fd, std::string name, char_type line_separator = '\n') :
+        filename(std::move(name)), fd(fd), line_separator(line_separator) {
+        read_data();
+    }
+
+    // reads blocks from reader, whose size is set at runtime rather than by buffer_size
+    inistream(std::unique_ptr<read_ahead_reader> reader, std::string name, char_type line_separator = '\n') :
+        filename(std::move(name)), ahead(std::move(reader)), line_separator(line_separator) {
+        read_data();
+    }
+
+    // streams over memory that is already loaded (or mapped). The memory is not
+    // copied and must outlive the stream and any view() taken from it
+    explicit inistream(std::basic_string_view<char_type> contents, char_type line_separator = '\n') :
+        data(contents.data()), max(contents.size()), contiguous_(true), line_separator(line_separator) { }
+
+    [[nodiscard]] bool eof() const { return idx >= max; }
+
+    // false if the file could not be opened
+    [[nodiscard]] bool is_open() const {
+        return contiguous_ || source != nullptr || fd >= 0 || ahead != nullptr || input.is_open();
+    }
+
+    // the read ahead reader, if the stream reads through one
+    [[nodiscard]] read_ahead_reader const* reader() const noexcept { return ahead.get(); }
+
+    // true if the stream reads a file it opened by name, which can be mapped instead
+    [[nodiscard]] bool reads_named_file() const noexcept { return !contiguous_ && source == nullptr && fd < 0; }
+
+    // true if the stream is over contiguous memory and view() may be used
+    [[nodiscard]] bool contiguous() const noexcept { return contiguous_; }
 
     void increment_pos_counts(char_type c) {
         current_pos_++;
         if (c == line_separator) {
             current_line_++;
             current_line_pos_ = 0;
+        } else {
+            current_line_pos_++;
         }
     }
 
     char_type peek() const noexcept {
-        return buf[idx];
+        return eof() ? char_type{ } : data[idx];
     }
 
     char_type consume() {
-        char_type c = buf[idx];
-        if (idx + 1 == max) {
+        char_type c = data[idx];
+        if (++idx == max)
             read_data();
-        } else {
-            idx++;
-        }
         increment_pos_counts(c);
         return c;
     }
 
+    // consumes n chars of the current window at once, n must not run past it
+    void advance(std::size_t n) {
+        char_type const* first = data + idx;
+        char_type const* last  = first + n;
+        auto const       lines = std::count(first, last, line_separator);
+
+        current_pos_ += static_cast<int>(n);
+        if (lines == 0) {
+            current_line_pos_ += static_cast<int>(n);
+        } else {
+            auto const after_last = std::find(std::make_reverse_iterator(last),
+                                              std::make_reverse_iterator(first),
+                                              line_separator).base();
+            current_line_ += static_cast<int>(lines);
+            current_line_pos_ = static_cast<int>(last - after_last);
+        }
+
+        idx += n;
+        if (idx == max)
+            read_data();
+    }
+
+    // consumes chars up to (but not including) the first one find stops at,
+    // refilling the buffer as needed. find(first, n) returns the index of the
+    // stop in [first, first + n) or n if there is none. Every consumed run of
+    // chars is handed to sink(first, n) before it is consumed
+    template <typename Find, typename Sink>
+    void consume_until(Find find, Sink sink) {
+        while (!eof()) {
+            std::size_t const available = max - idx;
+            std::size_t const n         = find(data + idx, available);
+            sink(data + idx, n);
+            advance(n);
+            if (n < available)
+                return;
+        }
+    }
+
+    // true if the next chars are token, without consuming them. Reads on if
+    // token runs past the current window, so it must be shorter than buffer_size
+    bool starts_with(std::basic_string_view<char_type> token) {
+        std::size_t const left = max - idx;
+        if (left < token.size() && !contiguous_ && left > 0) {
+            if (ahead != nullptr) {
+                // the current block is given back by next(), keep what is left of it
+                spill.assign(data + idx, left);
+                spill.append(ahead->next());
+                data = spill.data();
+                max  = spill.size();
+            } else {
+                if (idx > 0)
+                    std::copy(data + idx, data + max, buf.begin());
+                data = buf.data();
+                max  = left + read_into(buf.data() + left, buffer_size - left);
+            }
+            idx = 0;
+        }
+        return max - idx >= token.size() && std::equal(token.begin(), token.end(), data + idx);
+    }
+
+    // offset of the next char in the underlying contiguous memory
+    [[nodiscard]] std::size_t offset() const noexcept { return idx; }
+
+    // the chars consumed since offset() returned from. Only valid on a contiguous stream
+    [[nodiscard]] std::basic_string_view<char_type> view(std::size_t from) const noexcept {
+        return std::basic_string_view<char_type>{data + from, idx - from};
+    }
+
     [[nodiscard]] std::tuple<std::size_t, std::size_t, std::size_t> position() const {
         return std::tie(current_pos_, current_line_, current_line_pos_);
     }
@@ -0,0 +1,81 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tom {
+
+mapped_file::mapped_file(std::string filename_) : filename(std::move(filename_)) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + filename);
+
+    struct stat st{ };
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot stat " + filename);
+    }
+
+    size_ = static_cast<std::size_t>(st.st_size);
+
+    // mmap refuses zero length mappings, an empty file is just an empty view
+    if (size_ != 0) {
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "Cannot map " + filename);
+        }
+        // the parser walks the mapping front to back exactly once
+        ::madvise(addr, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<char const*>(addr);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept :
+    filename(std::move(other.filename)),
+    data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)) { }
+
+mapped_file& mapped_file::operator =(mapped_file&& other) noexcept {
+    if (&other != this) {
+        if (data_ != nullptr)
+            ::munmap(const_cast<char*>(data_), size_);
+        filename = std::move(other.filename);
+        data_    = std::exchange(other.data_, nullptr);
+        size_    = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+char const* mapped_file::data() const noexcept {
+    return data_;
+}
+
+std::size_t mapped_file::size() const noexcept {
+    return size_;
+}
+
+std::string_view mapped_file::view() const noexcept {
+    return std::string_view{data_, size_};
+}
+
+std::string const& mapped_file::get_filename() const noexcept {
+    return filename;
+}
+
+mapped_file::~mapped_file() {
+    if (data_ != nullptr)
+        ::munmap(const_cast<char*>(data_), size_);
+}
+
+}  // namespace tom
@@ -0,0 +1,42 @@
+#ifndef PARSEINI_MAPPED_FILE_H
+#define PARSEINI_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace tom {
+
+// read only memory mapping of an entire file. The mapping lives as long as the
+// object does, so anything holding views into it must also hold the mapped_file
+class mapped_file {
+    std::string filename;
+    char const* data_ = nullptr;
+    std::size_t size_ = 0;
+
+public:
+    // maps the whole file. Throws std::system_error if it cannot be opened or mapped
+    explicit mapped_file(std::string filename_);
+
+    mapped_file(mapped_file const&) = delete;
+
+    mapped_file(mapped_file&& other) noexcept;
+
+    mapped_file& operator =(mapped_file const&) = delete;
+
+    mapped_file& operator =(mapped_file&& other) noexcept;
+
+    [[nodiscard]] char const* data() const noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    [[nodiscard]] std::string_view view() const noexcept;
+
+    [[nodiscard]] std::string const& get_filename() const noexcept;
+
+    ~mapped_file();
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_MAPPED_FILE_H
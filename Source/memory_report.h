@@ -0,0 +1,132 @@
+#ifndef PARSEINI_MEMORY_REPORT_H
+#define PARSEINI_MEMORY_REPORT_H
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tom {
+
+// heap bytes held by part of an ini_file, by what they are spent on. Counts
+// what is asked of the allocator, not what malloc adds on top
+struct memory_report {
+    // key, value and name text stored outside the strings themselves
+    std::size_t strings = 0;
+    // entries and sections with their shared_ptr control blocks
+    std::size_t objects = 0;
+    // hash map nodes and the section lists of the key index
+    std::size_t nodes   = 0;
+    // hash map bucket arrays
+    std::size_t buckets = 0;
+    // the sections() and entries() vectors
+    std::size_t caches  = 0;
+    // text in string pools the file uses, which other files may share
+    std::size_t shared  = 0;
+
+    [[nodiscard]] std::size_t total() const noexcept {
+        return strings + objects + nodes + buckets + caches + shared;
+    }
+
+    memory_report& operator +=(memory_report const& other) noexcept {
+        strings += other.strings;
+        objects += other.objects;
+        nodes += other.nodes;
+        buckets += other.buckets;
+        caches += other.caches;
+        shared += other.shared;
+        return *this;
+    }
+};
+
+std::ostream& operator <<(std::ostream& os, memory_report const& self);
+
+namespace detail {
+
+// what counting_allocator has handed out on this thread
+inline thread_local std::size_t counted_bytes = 0;
+
+// an allocator that adds what it hands out to counted_bytes. The standard
+// library gives no way to ask how large a map node or a make_shared block is,
+// so they are measured by building one with this allocator
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(counting_allocator<U> const&) noexcept { }
+
+    T* allocate(std::size_t n) {
+        counted_bytes += n * sizeof(T);
+        return std::allocator<T>{ }.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        std::allocator<T>{ }.deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator ==(counting_allocator<U> const&) const noexcept { return true; }
+};
+
+// bytes allocated for one node of Map
+template <typename Map>
+std::size_t node_bytes() {
+    static std::size_t const bytes = [] {
+        using value_type = typename Map::value_type;
+        using counted    = std::unordered_map<typename Map::key_type, typename Map::mapped_type, typename Map::hasher,
+                                              typename Map::key_equal, counting_allocator<value_type>>;
+        counted map{ };
+        map.reserve(8);
+        auto const before = counted_bytes;
+        map.emplace(typename Map::key_type{ }, typename Map::mapped_type{ });
+        return counted_bytes - before;
+    }();
+    return bytes;
+}
+
+// bytes allocated by make_shared<T>, object and control block together
+template <typename T>
+std::size_t shared_object_bytes() {
+    // something of the same size and alignment, T may not be default constructible
+    struct alignas(T) stand_in {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    static std::size_t const bytes = [] {
+        auto const before = counted_bytes;
+        [[maybe_unused]] auto const object = std::allocate_shared<stand_in>(counting_allocator<stand_in>{ });
+        return counted_bytes - before;
+    }();
+    return bytes;
+}
+
+// text held outside the string object, 0 while it fits in the string itself
+inline std::size_t heap_bytes(std::string const& text) noexcept {
+    auto const* first = reinterpret_cast<char const*>(&text);
+    bool const  local = text.data() >= first && text.data() < first + sizeof text;
+    return local ? 0 : text.capacity() + 1;
+}
+
+template <typename Map>
+void count_map(Map const& map, memory_report& report) {
+    report.nodes += map.size() * node_bytes<Map>();
+    // a map that never grew uses a bucket inside itself
+    if (map.bucket_count() > 1)
+        report.buckets += map.bucket_count() * sizeof(void*);
+}
+
+template <typename T>
+std::size_t vector_bytes(std::vector<T> const& items) noexcept {
+    return items.capacity() * sizeof(T);
+}
+
+}  // namespace detail
+
+}  // namespace tom
+
+#endif  // PARSEINI_MEMORY_REPORT_H
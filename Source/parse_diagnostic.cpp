@@ -0,0 +1,22 @@
+#include "parse_diagnostic.h"
+
+namespace tom {
+
+std::string parse_diagnostic::message(std::string_view filename) const {
+    std::string text{ };
+    switch (kind) {
+        case diagnostic_kind::unterminated_section:
+            text = "Unterminated section name: ";
+            break;
+        case diagnostic_kind::empty_section_name:
+            text = "Cannot have section with empty name: ";
+            break;
+        case diagnostic_kind::malformed_line:
+            break;
+    }
+    text.append("INI Parsing of ").append(filename).append(" has failed at line: ").append(std::to_string(line));
+    text.append(", col: ").append(std::to_string(column)).append(" (").append(std::to_string(offset)).append(")");
+    return text;
+}
+
+}  // namespace tom
@@ -0,0 +1,37 @@
+#ifndef PARSEINI_PARSE_DIAGNOSTIC_H
+#define PARSEINI_PARSE_DIAGNOSTIC_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace tom {
+
+enum class diagnostic_kind {
+    // a line that is not a section, an entry or a comment
+    malformed_line,
+    // a '[' with no ']' before the end of the input
+    unterminated_section,
+    // "[]"
+    empty_section_name
+};
+
+// where and why a parse failed, without any text. Positions are where the
+// parser noticed the problem, which for a malformed line can be the start of
+// the next line
+struct parse_diagnostic {
+    diagnostic_kind kind   = diagnostic_kind::malformed_line;
+    // from 1
+    std::size_t     line   = 1;
+    // chars since the start of the line, from 0
+    std::size_t     column = 0;
+    // chars since the start of the input
+    std::size_t     offset = 0;
+
+    // the message parse() throws for the same problem in a file named filename
+    [[nodiscard]] std::string message(std::string_view filename) const;
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_PARSE_DIAGNOSTIC_H
@@ -19,7 +19,7 @@ public:
     [[nodiscard]] const char* what() const noexcept override;
 };
 
-class empty_section_name: parse_error {
+class empty_section_name: public parse_error {
 public:
     explicit empty_section_name(std::string string) : parse_error(std::move(string)) {}
 };
@@ -0,0 +1,107 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace tom::perfect_hash {
+
+namespace {
+
+// displacements tried for one bucket before giving up on a seed, and seeds
+// tried before giving up. A random seed needs few displacements per bucket,
+// so neither limit is reached in practice
+constexpr std::int32_t max_displacement = 1 << 16;
+constexpr std::int32_t max_seeds        = 64;
+
+// places hashes, already seeded, over n slots. False if a bucket would not fit
+bool place(std::vector<std::uint64_t> const& hashes, std::int32_t* displacements, std::vector<std::uint32_t>& slots) {
+    auto const n = static_cast<std::uint32_t>(hashes.size());
+
+    std::vector<std::vector<std::uint32_t>> buckets(n);
+    for (std::uint32_t i = 0; i < n; i++)
+        buckets[bucket(hashes[i], n)].push_back(i);
+
+    // the fullest buckets are placed first, while most slots are free
+    std::vector<std::uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](auto a, auto b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<bool>          taken(n, false);
+    std::vector<std::uint32_t> trial{ };
+    std::fill(displacements, displacements + n, 0);
+
+    std::size_t next = 0;
+    for (; next < n && buckets[order[next]].size() > 1; next++) {
+        auto const& members = buckets[order[next]];
+        bool        placed  = false;
+        for (std::int32_t d = 1; d <= max_displacement && !placed; d++) {
+            trial.clear();
+            bool fits = true;
+            for (auto member : members) {
+                auto const at = displaced(hashes[member], d, n);
+                if (taken[at] || std::find(trial.begin(), trial.end(), at) != trial.end()) {
+                    fits = false;
+                    break;
+                }
+                trial.push_back(at);
+            }
+            if (!fits)
+                continue;
+
+            for (std::size_t k = 0; k < members.size(); k++) {
+                taken[trial[k]]     = true;
+                slots[members[k]] = trial[k];
+            }
+            displacements[order[next]] = d;
+            placed                     = true;
+        }
+        if (!placed)
+            return false;
+    }
+
+    // single hash buckets take whatever is left, empty ones need nothing
+    std::uint32_t free_slot = 0;
+    for (; next < n && buckets[order[next]].size() == 1; next++) {
+        while (taken[free_slot])
+            free_slot++;
+        taken[free_slot]                    = true;
+        slots[buckets[order[next]].front()] = free_slot;
+        displacements[order[next]]          = -static_cast<std::int32_t>(free_slot) - 1;
+    }
+    return true;
+}
+
+}  // namespace
+
+std::vector<std::uint32_t> build(std::vector<std::uint64_t> const& hashes, std::vector<std::int32_t>& tables) {
+    auto const                 n = static_cast<std::uint32_t>(hashes.size());
+    std::vector<std::uint32_t> slots(n, 0);
+
+    std::vector<std::uint64_t> sorted = hashes;
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        throw std::invalid_argument("Cannot build a perfect hash, two hashes are equal");
+
+    std::size_t const base = tables.size();
+    tables.resize(base + 1 + n, 0);
+
+    std::vector<std::uint64_t> seeded_hashes(n);
+    for (std::int32_t seed = 0; seed < max_seeds; seed++) {
+        // distinct hashes stay distinct, the seed is xor'ed in
+        std::transform(hashes.begin(), hashes.end(), seeded_hashes.begin(), [seed](auto hash) {
+            return seeded(hash, seed);
+        });
+        if (place(seeded_hashes, tables.data() + base + 1, slots)) {
+            tables[base] = seed;
+            return slots;
+        }
+    }
+
+    tables.resize(base);
+    throw std::runtime_error("Cannot build a perfect hash, no seed places every bucket");
+}
+
+}  // namespace tom::perfect_hash
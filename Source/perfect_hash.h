@@ -0,0 +1,68 @@
+#ifndef PARSEINI_PERFECT_HASH_H
+#define PARSEINI_PERFECT_HASH_H
+
+#include <cstdint>
+#include <vector>
+
+namespace tom {
+
+// minimal perfect hashing by hash and displace. n distinct 64 bit hashes are
+// spread over n buckets, and every bucket gets a displacement that sends its
+// hashes to slots no other bucket uses, so the n hashes land on the slots 0
+// to n - 1 without collisions. A displacement below 0 stores the slot of a
+// bucket with a single hash directly. A table is a seed followed by the n
+// displacements, the seed changes how hashes fall into buckets and is tried
+// again with another value when some bucket cannot be placed
+namespace perfect_hash {
+
+// a 64 bit finalizer, so hashes that differ in a few bits still spread
+constexpr std::uint64_t mix(std::uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// maps x onto 0 to n - 1 with a multiply instead of a division, the high
+// half of the 96 bit product x * n
+constexpr std::uint32_t reduce(std::uint64_t x, std::uint32_t n) noexcept {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<std::uint32_t>((static_cast<unsigned __int128>(x) * n) >> 64);
+#else
+    std::uint64_t const low = (x & 0xffffffffull) * n;
+    return static_cast<std::uint32_t>(((x >> 32) * n + (low >> 32)) >> 32);
+#endif
+}
+
+constexpr std::uint64_t seeded(std::uint64_t hash, std::int32_t seed) noexcept {
+    return hash ^ static_cast<std::uint64_t>(static_cast<std::uint32_t>(seed)) * 0xD6E8FEB86659FD93ull;
+}
+
+constexpr std::uint32_t bucket(std::uint64_t hash, std::uint32_t n) noexcept {
+    return reduce(mix(hash), n);
+}
+
+constexpr std::uint32_t displaced(std::uint64_t hash, std::int32_t displacement, std::uint32_t n) noexcept {
+    return reduce(mix(hash + static_cast<std::uint64_t>(displacement) * 0x9E3779B97F4A7C15ull), n);
+}
+
+// the slot of hash, given the table built for a set it belongs to. For a
+// hash outside the set the slot is arbitrary but below n
+inline std::uint32_t slot(std::int32_t const* table, std::uint32_t n, std::uint64_t hash) noexcept {
+    hash                 = seeded(hash, table[0]);
+    std::int32_t const d = table[1 + bucket(hash, n)];
+    return d < 0 ? static_cast<std::uint32_t>(-d - 1) : displaced(hash, d, n);
+}
+
+// appends the n + 1 entries of the table for hashes to tables and returns
+// the slot of every hash. Throws std::invalid_argument if two hashes are
+// equal, and std::runtime_error in the unlikely case no seed tried works
+std::vector<std::uint32_t> build(std::vector<std::uint64_t> const& hashes, std::vector<std::int32_t>& tables);
+
+}  // namespace perfect_hash
+
+}  // namespace tom
+
+#endif  // PARSEINI_PERFECT_HASH_H
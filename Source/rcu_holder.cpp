@@ -0,0 +1,91 @@
+#include "rcu_holder.h"
+
+#include <algorithm>
+#include <limits>
+#include "ini_file.h"
+
+namespace tom {
+
+namespace {
+
+// unregisters the thread's record when the thread exits
+struct local_reader {
+    epoch_domain::reader_record record{ };
+    epoch_domain*               domain = nullptr;
+
+    ~local_reader() {
+        if (domain != nullptr)
+            domain->unregister(&record);
+    }
+};
+
+}  // namespace
+
+epoch_domain& epoch_domain::global() {
+    // never destroyed, threads exiting after main returns still unregister
+    static auto* domain = new epoch_domain{ };
+    return *domain;
+}
+
+epoch_domain::reader_record& epoch_domain::local() {
+    thread_local local_reader reader{ };
+    if (reader.domain == nullptr) {
+        std::lock_guard<std::mutex> guard{lock};
+        readers.push_back(&reader.record);
+        reader.domain = this;
+    }
+    return reader.record;
+}
+
+void epoch_domain::enter(reader_record& record) noexcept {
+    // nested reads keep the epoch of the outermost one
+    if (record.depth++ == 0)
+        record.epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+void epoch_domain::leave(reader_record& record) noexcept {
+    if (--record.depth == 0)
+        record.epoch.store(0, std::memory_order_release);
+}
+
+void epoch_domain::retire(void const* object, void (*destroy)(void const*)) {
+    std::lock_guard<std::mutex> guard{lock};
+    // readers that announce a later epoch started after object was unpublished
+    retired.push_back(retired_object{object, destroy, global_epoch.fetch_add(1, std::memory_order_seq_cst)});
+    reclaim_locked();
+}
+
+std::size_t epoch_domain::reclaim_locked() {
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    for (auto const* reader : readers) {
+        auto const epoch = reader->epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0)
+            oldest = std::min(oldest, epoch);
+    }
+
+    auto const still_visible = std::partition(retired.begin(), retired.end(), [oldest](retired_object const& each) {
+        return each.epoch >= oldest;
+    });
+    for (auto it = still_visible; it != retired.end(); ++it)
+        it->destroy(it->object);
+    retired.erase(still_visible, retired.end());
+    return retired.size();
+}
+
+std::size_t epoch_domain::reclaim() {
+    std::lock_guard<std::mutex> guard{lock};
+    return reclaim_locked();
+}
+
+void epoch_domain::unregister(reader_record* record) {
+    std::lock_guard<std::mutex> guard{lock};
+    readers.erase(std::remove(readers.begin(), readers.end(), record), readers.end());
+}
+
+void prepare_for_readers(ini_file const& file) {
+    static_cast<void>(file.sections());
+    for (auto const& section : file.each_section())
+        section.entries();
+}
+
+}  // namespace tom
@@ -0,0 +1,178 @@
+#ifndef PARSEINI_RCU_HOLDER_H
+#define PARSEINI_RCU_HOLDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tom {
+
+struct ini_file;
+
+// epoch based reclamation shared by every rcu_holder in the process. Each
+// thread that reads announces the epoch it started reading in, objects are
+// retired with the epoch they were unpublished in, and an object is only
+// destroyed once every thread still reading started after it was retired
+class epoch_domain {
+public:
+    struct alignas(64) reader_record {
+        // 0 while the thread is not reading
+        std::atomic<std::uint64_t> epoch{0};
+        std::size_t                depth = 0;
+    };
+
+private:
+    struct retired_object {
+        void const*   object;
+        void        (*destroy)(void const*);
+        std::uint64_t epoch;
+    };
+
+    std::atomic<std::uint64_t> global_epoch{1};
+
+    // only touched by writers and by threads starting or exiting
+    std::mutex                  lock;
+    std::vector<reader_record*> readers{ };
+    std::vector<retired_object> retired{ };
+
+    epoch_domain() = default;
+
+    // destroys what no reader can still see, lock must be held
+    std::size_t reclaim_locked();
+
+public:
+    static epoch_domain& global();
+
+    // the calling thread's record, registered on its first read
+    reader_record& local();
+
+    void enter(reader_record& record) noexcept;
+
+    void leave(reader_record& record) noexcept;
+
+    // hands object over to be destroyed by destroy once no reader can see it.
+    // It must already be unreachable for new readers
+    void retire(void const* object, void (*destroy)(void const*));
+
+    // destroys what can be destroyed now, returns how many objects are left
+    std::size_t reclaim();
+
+    void unregister(reader_record* record);
+};
+
+// readies an object for readers on many threads, run once before it is
+// published. The default does nothing
+template <typename T>
+void prepare_for_readers(T const&) { }
+
+// ini_file fills its section and entry caches on first use, which is not
+// safe from several threads at once, so they are filled in before publishing.
+// Reading entries writes nothing but their cached_value, which is safe to fill
+// from several threads
+void prepare_for_readers(ini_file const& file);
+
+// holds the current version of an object that many threads read while one
+// thread now and then replaces it. Readers take no lock and touch no shared
+// reference count, a read is two stores to the reader's own cache line and
+// one load of the pointer. Replaced versions are destroyed once the last
+// reader that could see them is done.
+//
+//     rcu_holder<ini_file> config{std::make_unique<ini_file>(parser.parse())};
+//     auto current = config.read();
+//     current->get_entry("Port");
+//
+// Published objects are only ever read through const references
+template <typename T>
+class rcu_holder {
+    std::atomic<T const*> current{nullptr};
+    epoch_domain&         domain = epoch_domain::global();
+
+    static void destroy(void const* object) {
+        delete static_cast<T const*>(object);
+    }
+
+public:
+    // keeps the version that was current when it was made alive until it is
+    // destroyed. Meant to live on one thread for the length of a lookup
+    class read_guard {
+        epoch_domain*                 domain = nullptr;
+        epoch_domain::reader_record*  record = nullptr;
+        T const*                      object = nullptr;
+
+        friend class rcu_holder;
+
+        read_guard(epoch_domain& domain, std::atomic<T const*> const& current) :
+            domain(&domain), record(&domain.local()) {
+            domain.enter(*record);
+            object = current.load(std::memory_order_seq_cst);
+        }
+
+    public:
+        read_guard(read_guard&& other) noexcept :
+            domain(other.domain), record(other.record), object(other.object) {
+            other.record = nullptr;
+        }
+
+        read_guard(read_guard const&) = delete;
+
+        read_guard& operator =(read_guard const&) = delete;
+
+        read_guard& operator =(read_guard&&) = delete;
+
+        T const& operator *() const noexcept { return *object; }
+
+        T const* operator ->() const noexcept { return object; }
+
+        [[nodiscard]] T const* get() const noexcept { return object; }
+
+        explicit operator bool() const noexcept { return object != nullptr; }
+
+        ~read_guard() {
+            if (record != nullptr)
+                domain->leave(*record);
+        }
+    };
+
+    rcu_holder() = default;
+
+    explicit rcu_holder(std::unique_ptr<T> initial) {
+        publish(std::move(initial));
+    }
+
+    rcu_holder(rcu_holder const&) = delete;
+
+    rcu_holder& operator =(rcu_holder const&) = delete;
+
+    [[nodiscard]] read_guard read() const {
+        return read_guard{domain, current};
+    }
+
+    // makes next the current version. The one it replaces is destroyed once
+    // no reader can see it, which may be later, on whichever thread publishes
+    // or reclaims then
+    void publish(std::unique_ptr<T> next) {
+        if (next != nullptr)
+            prepare_for_readers(static_cast<T const&>(*next));
+        T const* previous = current.exchange(next.release(), std::memory_order_seq_cst);
+        if (previous != nullptr)
+            domain.retire(previous, &destroy);
+    }
+
+    // destroys replaced versions no reader can see anymore
+    void reclaim() {
+        domain.reclaim();
+    }
+
+    // there must be no readers left
+    ~rcu_holder() {
+        delete current.exchange(nullptr);
+        domain.reclaim();
+    }
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_RCU_HOLDER_H
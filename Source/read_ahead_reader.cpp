@@ -0,0 +1,145 @@
+#include "read_ahead_reader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace tom {
+
+read_ahead_reader::read_ahead_reader(std::string filename_, read_ahead_options options_) :
+    filename(std::move(filename_)), options(options_) {
+    options.block_size = std::max<std::size_t>(options.block_size, 1);
+    options.blocks     = std::max<std::size_t>(options.blocks, 1);
+
+    fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + filename);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    for (std::size_t i = 0; i < options.blocks; i++)
+        buffers.push_back(std::make_unique<char[]>(options.block_size));
+    sizes.resize(options.blocks);
+
+    if (options.blocks < 2)
+        return;
+    try {
+        reader = std::thread{[this] { run(); }};
+    } catch (std::system_error const&) {
+        // no thread to read ahead on, next() reads each block itself
+    }
+}
+
+std::size_t read_ahead_reader::read_block(char* buffer) {
+    std::size_t got = 0;
+    while (got < options.block_size) {
+        auto const n = ::read(fd, buffer + got, options.block_size - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw std::system_error(errno, std::generic_category(), "Cannot read " + filename);
+        if (n == 0)
+            break;
+        got += static_cast<std::size_t>(n);
+    }
+    return got;
+}
+
+void read_ahead_reader::run() {
+    for (;;) {
+        std::size_t slot;
+        {
+            std::unique_lock<std::mutex> guard{lock};
+            // the block being scanned is consumed - 1, the one after the
+            // last read must not be it
+            block_free.wait(guard, [this] { return stopping || filled + 1 < consumed + options.blocks; });
+            if (stopping)
+                return;
+            slot = filled % options.blocks;
+        }
+
+        std::size_t        size = 0;
+        std::exception_ptr failure{ };
+        try {
+            size = read_block(buffers[slot].get());
+        } catch (...) {
+            failure = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> guard{lock};
+        if (failure != nullptr) {
+            error    = failure;
+            finished = true;
+        } else if (size > 0) {
+            sizes[slot] = size;
+            filled++;
+        }
+        // a short block is the last one
+        if (size < options.block_size)
+            finished = true;
+        block_read.notify_one();
+        if (finished)
+            return;
+    }
+}
+
+std::string_view read_ahead_reader::next() {
+    auto const started = std::chrono::steady_clock::now();
+
+    if (!reader.joinable()) {
+        // read in place: the one buffer is free again once next() is called
+        if (finished)
+            return { };
+        std::size_t const size = read_block(buffers[0].get());
+        if (size < options.block_size)
+            finished = true;
+        stats_.waited += std::chrono::steady_clock::now() - started;
+        stats_.stalls++;
+        if (size == 0)
+            return { };
+        stats_.blocks++;
+        stats_.bytes += size;
+        return {buffers[0].get(), size};
+    }
+
+    std::unique_lock<std::mutex> guard{lock};
+    if (filled == consumed && !finished) {
+        stats_.stalls++;
+        block_read.wait(guard, [this] { return filled > consumed || finished; });
+        stats_.waited += std::chrono::steady_clock::now() - started;
+    }
+
+    if (filled == consumed) {
+        if (error != nullptr)
+            std::rethrow_exception(std::exchange(error, nullptr));
+        return { };
+    }
+
+    std::size_t const slot = consumed++ % options.blocks;
+    stats_.blocks++;
+    stats_.bytes += sizes[slot];
+    // the previous block is free to be read into now
+    block_free.notify_one();
+    return {buffers[slot].get(), sizes[slot]};
+}
+
+read_ahead_stats const& read_ahead_reader::stats() const noexcept {
+    return stats_;
+}
+
+read_ahead_reader::~read_ahead_reader() {
+    if (reader.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard{lock};
+            stopping = true;
+        }
+        block_free.notify_one();
+        reader.join();
+    }
+    if (fd >= 0)
+        ::close(fd);
+}
+
+}  // namespace tom
@@ -0,0 +1,82 @@
+#ifndef PARSEINI_READ_AHEAD_READER_H
+#define PARSEINI_READ_AHEAD_READER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace tom {
+
+struct read_ahead_options {
+    // bytes read at a time
+    std::size_t block_size = 1 << 20;
+    // blocks in flight. With fewer than 2 there is nothing to read into while
+    // one is scanned, so blocks are read on the calling thread instead
+    std::size_t blocks = 2;
+};
+
+struct read_ahead_stats {
+    // time next() spent waiting for a block to be read
+    std::chrono::nanoseconds waited{0};
+    // blocks handed out, and how many of them were not ready when asked for
+    std::size_t              blocks = 0;
+    std::size_t              stalls = 0;
+    std::size_t              bytes  = 0;
+};
+
+// reads a file a block at a time on a thread of its own, up to blocks - 1
+// blocks ahead of the one being scanned, so reading overlaps with parsing
+class read_ahead_reader {
+    std::string                           filename;
+    int                                   fd = -1;
+    read_ahead_options                    options;
+    std::vector<std::unique_ptr<char[]>>  buffers{ };
+    std::vector<std::size_t>              sizes{ };
+
+    // blocks read so far and blocks handed to next(). The block before the
+    // last one handed out has been scanned and can be read into again
+    std::mutex              lock;
+    std::condition_variable block_read;
+    std::condition_variable block_free;
+    std::size_t             filled   = 0;
+    std::size_t             consumed = 0;
+    bool                    finished = false;
+    bool                    stopping = false;
+    std::exception_ptr      error{ };
+
+    read_ahead_stats stats_{ };
+    std::thread      reader{ };
+
+    // fills buffer with up to block_size bytes, fewer only at the end of the file
+    std::size_t read_block(char* buffer);
+
+    void run();
+
+public:
+    // opens filename. Throws std::system_error if it cannot be opened
+    explicit read_ahead_reader(std::string filename, read_ahead_options options = { });
+
+    read_ahead_reader(read_ahead_reader const&) = delete;
+
+    read_ahead_reader& operator =(read_ahead_reader const&) = delete;
+
+    // the next block of the file, empty at the end. The previous block is
+    // given back and must no longer be used. Throws std::system_error if
+    // reading failed
+    std::string_view next();
+
+    [[nodiscard]] read_ahead_stats const& stats() const noexcept;
+
+    ~read_ahead_reader();
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_READ_AHEAD_READER_H
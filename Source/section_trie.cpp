@@ -0,0 +1,131 @@
+#include "section_trie.h"
+
+#include "ini_section.h"
+
+namespace tom {
+
+namespace {
+
+// calls part for each piece of name between separators, in order. The empty
+// name has no pieces
+template <typename Part>
+void for_each_part(std::string_view name, Part part) {
+    if (name.empty())
+        return;
+    std::size_t start = 0;
+    for (;;) {
+        auto const end = name.find(section_trie::separator, start);
+        part(name.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+        if (end == std::string_view::npos)
+            return;
+        start = end + 1;
+    }
+}
+
+}  // namespace
+
+section_trie::node const* section_trie::find(std::string_view name) const {
+    node const* at = &root;
+    for_each_part(name, [&at](std::string_view part) {
+        if (at == nullptr)
+            return;
+        auto const it = at->children.find(part);
+        at = it == at->children.end() ? nullptr : it->second.get();
+    });
+    return at;
+}
+
+void section_trie::insert(ini_section* section) {
+    std::vector<node*> path{&root};
+    for_each_part(section->name, [this, &path](std::string_view part) {
+        auto& children = path.back()->children;
+        auto  it       = children.find(part);
+        if (it == children.end()) {
+            it = children.emplace(std::string{part}, std::make_unique<node>()).first;
+            node_count++;
+        }
+        path.push_back(it->second.get());
+    });
+
+    bool const replacing = path.back()->section != nullptr;
+    path.back()->section = section;
+    if (!replacing)
+        for (auto* each : path)
+            each->sections++;
+}
+
+void section_trie::erase(ini_section const* section) {
+    std::vector<node*> path{&root};
+    for_each_part(section->name, [&path](std::string_view part) {
+        if (path.back() == nullptr)
+            return;
+        auto const it = path.back()->children.find(part);
+        path.push_back(it == path.back()->children.end() ? nullptr : it->second.get());
+    });
+    if (path.back() == nullptr || path.back()->section != section)
+        return;
+
+    path.back()->section = nullptr;
+    for (auto* each : path)
+        each->sections--;
+
+    // a node left without sections has no children either
+    std::size_t depth = path.size() - 1;
+    while (depth > 0 && path[depth]->sections == 0) {
+        auto& siblings = path[depth - 1]->children;
+        for (auto it = siblings.begin(); it != siblings.end(); ++it) {
+            if (it->second.get() == path[depth]) {
+                siblings.erase(it);
+                break;
+            }
+        }
+        node_count--;
+        depth--;
+    }
+}
+
+ini_section* section_trie::find_section(std::string_view name) const {
+    auto const* at = find(name);
+    return at == nullptr ? nullptr : at->section;
+}
+
+std::vector<ini_section*> section_trie::ancestors(std::string_view name) const {
+    // the sections on the path to name, the last one may be name's own
+    std::vector<ini_section*> found{ };
+    node const*               at = &root;
+    for_each_part(name, [&at, &found](std::string_view part) {
+        if (at == nullptr)
+            return;
+        auto const it = at->children.find(part);
+        at = it == at->children.end() ? nullptr : it->second.get();
+        if (at != nullptr && at->section != nullptr)
+            found.push_back(at->section);
+    });
+    if (at != nullptr && at->section != nullptr)
+        found.pop_back();
+    return {found.rbegin(), found.rend()};
+}
+
+std::size_t section_trie::count(std::string_view prefix) const {
+    auto const* at = find(prefix);
+    return at == nullptr ? 0 : at->sections;
+}
+
+void section_trie::count_memory(memory_report& report) const {
+    // a map node is the pair plus the tree's color and three links
+    constexpr std::size_t per_node = sizeof(node) + sizeof(std::pair<std::string const, std::unique_ptr<node>>)
+                                     + 4 * sizeof(void*);
+    report.nodes += node_count * per_node;
+
+    struct walk {
+        static void labels(node const& at, memory_report& report) {
+            for (auto const& [label, child] : at.children) {
+                report.strings += detail::heap_bytes(label);
+                labels(*child, report);
+            }
+        }
+    };
+    walk::labels(root, report);
+}
+
+}  // namespace tom
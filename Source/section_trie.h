@@ -0,0 +1,83 @@
+#ifndef PARSEINI_SECTION_TRIE_H
+#define PARSEINI_SECTION_TRIE_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "memory_report.h"
+
+namespace tom {
+
+struct ini_section;
+
+// indexes sections by the parts of their name between dots, so "servers.eu.db1"
+// sits below "servers.eu", which sits below "servers". A part may have no
+// section of its own, "servers" need not exist for "servers.eu" to. Queries
+// only visit the nodes on the path to a name and, for subtrees, below it
+class section_trie {
+public:
+    static constexpr char separator = '.';
+
+private:
+    struct node {
+        ini_section*                                            section = nullptr;
+        // sections at or below this node, nodes without any are removed
+        std::size_t                                             sections = 0;
+        // by name so subtrees are visited in a stable order
+        std::map<std::string, std::unique_ptr<node>, std::less<>> children{ };
+    };
+
+    node        root{ };
+    std::size_t node_count = 0;
+
+    [[nodiscard]] node const* find(std::string_view name) const;
+
+    template <typename Visit>
+    static void visit_node(node const& at, Visit& visit) {
+        if (at.section != nullptr)
+            visit(*at.section);
+        for (auto const& [label, child] : at.children)
+            visit_node(*child, visit);
+    }
+
+public:
+    section_trie() = default;
+
+    section_trie(section_trie&&) noexcept = default;
+
+    section_trie& operator =(section_trie&&) noexcept = default;
+
+    // adds section under its name, replacing any section of the same name
+    void insert(ini_section* section);
+
+    // removes section if it is the one indexed under its name
+    void erase(ini_section const* section);
+
+    [[nodiscard]] ini_section* find_section(std::string_view name) const;
+
+    // the sections whose names are dotted prefixes of name, closest first.
+    // name itself is not included
+    [[nodiscard]] std::vector<ini_section*> ancestors(std::string_view name) const;
+
+    // the section named prefix, if any, then every section below it, parents
+    // before children and siblings by name. An empty prefix visits them all
+    template <typename Visit>
+    void visit(std::string_view prefix, Visit&& visit) const {
+        if (auto const* at = find(prefix); at != nullptr)
+            visit_node(*at, visit);
+    }
+
+    // sections at or below prefix
+    [[nodiscard]] std::size_t count(std::string_view prefix) const;
+
+    // adds what the nodes and their labels hold to report
+    void count_memory(memory_report& report) const;
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_SECTION_TRIE_H
@@ -0,0 +1,44 @@
+#include "string_pool.h"
+
+#include <cstring>
+#include <functional>
+
+namespace tom {
+
+std::string_view string_pool::intern(std::string_view text) {
+    std::size_t const hash  = std::hash<std::string_view>{ }(text);
+    shard&            owner = shards[hash % shard_count];
+
+    std::lock_guard<std::mutex> guard{owner.lock};
+    if (auto it = owner.strings.find(text); it != owner.strings.end())
+        return *it;
+
+    auto* storage = static_cast<char*>(owner.arena.allocate(text.size() + 1, 1));
+    std::memcpy(storage, text.data(), text.size());
+    storage[text.size()] = '\0';
+
+    std::string_view const stored{storage, text.size()};
+    owner.strings.insert(stored);
+    owner.bytes += text.size();
+    return stored;
+}
+
+std::size_t string_pool::size() const {
+    std::size_t total = 0;
+    for (auto const& each : shards) {
+        std::lock_guard<std::mutex> guard{each.lock};
+        total += each.strings.size();
+    }
+    return total;
+}
+
+std::size_t string_pool::bytes() const {
+    std::size_t total = 0;
+    for (auto const& each : shards) {
+        std::lock_guard<std::mutex> guard{each.lock};
+        total += each.bytes;
+    }
+    return total;
+}
+
+}  // namespace tom
@@ -0,0 +1,50 @@
+#ifndef PARSEINI_STRING_POOL_H
+#define PARSEINI_STRING_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+
+namespace tom {
+
+// stores each distinct string once and hands out views of the stored copy.
+// The views stay valid for as long as the pool lives, and two views from one
+// pool are equal exactly when they point at the same chars, which
+// string_equal checks before comparing any. Safe to use from many
+// threads at once: strings are spread over independently locked shards by
+// their hash so parsers working on different files rarely wait on each other
+class string_pool {
+    static constexpr std::size_t shard_count = 16;
+
+    struct shard {
+        mutable std::mutex                   lock;
+        std::pmr::monotonic_buffer_resource  arena{4096};
+        std::unordered_set<std::string_view> strings;
+        std::size_t                          bytes = 0;
+    };
+
+    std::array<shard, shard_count> shards;
+
+public:
+    string_pool() = default;
+
+    string_pool(string_pool const&) = delete;
+
+    string_pool& operator =(string_pool const&) = delete;
+
+    // the pooled copy of text, stored on first sight
+    std::string_view intern(std::string_view text);
+
+    // number of distinct strings stored
+    [[nodiscard]] std::size_t size() const;
+
+    // bytes of string data stored
+    [[nodiscard]] std::size_t bytes() const;
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_STRING_POOL_H
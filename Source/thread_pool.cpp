@@ -0,0 +1,129 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace tom {
+
+namespace {
+
+// which pool and queue the current thread works for, if any
+thread_local thread_pool const* current_pool  = nullptr;
+thread_local std::size_t        current_queue = 0;
+
+}  // namespace
+
+thread_pool::thread_pool(unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<worker_queue>());
+
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back([this, i] { worker_loop(i); });
+}
+
+bool thread_pool::try_run_one(std::size_t home) {
+    std::function<void()> task{ };
+
+    {
+        auto& own = *queues[home];
+        std::lock_guard<std::mutex> guard{own.lock};
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    for (std::size_t k = 1; !task && k < queues.size(); k++) {
+        auto& victim = *queues[(home + k) % queues.size()];
+        std::lock_guard<std::mutex> guard{victim.lock};
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task)
+        return false;
+
+    queued--;
+    task();
+
+    {
+        std::lock_guard<std::mutex> guard{sleep_lock};
+    }
+    task_finished.notify_all();
+    return true;
+}
+
+void thread_pool::worker_loop(std::size_t index) {
+    current_pool  = this;
+    current_queue = index;
+
+    while (true) {
+        if (try_run_one(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock{sleep_lock};
+        work_available.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+            return;
+    }
+}
+
+void thread_pool::submit(std::function<void()> task) {
+    std::size_t const target = current_pool == this ? current_queue : next_queue++ % queues.size();
+
+    // counted before it is queued so a worker taking it never sees queued
+    // drop below zero
+    {
+        std::lock_guard<std::mutex> guard{sleep_lock};
+        queued++;
+    }
+
+    {
+        auto& queue = *queues[target];
+        std::lock_guard<std::mutex> guard{queue.lock};
+        queue.tasks.push_back(std::move(task));
+    }
+    work_available.notify_one();
+}
+
+void thread_pool::run_until(std::function<bool()> const& done) {
+    std::size_t const home = current_pool == this ? current_queue : 0;
+
+    while (!done()) {
+        if (try_run_one(home))
+            continue;
+
+        // nothing left to help with, wait for someone else's task to finish.
+        // The timeout covers done() becoming true without a task finishing
+        std::unique_lock<std::mutex> lock{sleep_lock};
+        task_finished.wait_for(lock, std::chrono::milliseconds(1), [this, &done] { return queued > 0 || done(); });
+    }
+}
+
+std::size_t thread_pool::size() const noexcept {
+    return workers.size();
+}
+
+thread_pool& thread_pool::shared() {
+    static thread_pool pool{ };
+    return pool;
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard{sleep_lock};
+        stopping = true;
+    }
+    work_available.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+}  // namespace tom
@@ -0,0 +1,68 @@
+#ifndef PARSEINI_THREAD_POOL_H
+#define PARSEINI_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tom {
+
+// a fixed number of worker threads, each with its own task queue. A worker
+// takes its newest task first and, when its own queue is empty, steals the
+// oldest task from another worker. Tasks submitted from a worker go on that
+// worker's queue, everything else is spread round robin
+class thread_pool {
+    struct worker_queue {
+        std::mutex                        lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread>                   workers;
+
+    // sleeping workers and run_until callers wait on these
+    std::mutex              sleep_lock;
+    std::condition_variable work_available;
+    std::condition_variable task_finished;
+
+    std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> next_queue{0};
+    bool                     stopping = false;
+
+    // runs one task, from queue home if it has one, otherwise stolen
+    bool try_run_one(std::size_t home);
+
+    void worker_loop(std::size_t index);
+
+public:
+    // threads == 0 means one per core
+    explicit thread_pool(unsigned threads = 0);
+
+    thread_pool(thread_pool const&) = delete;
+
+    thread_pool& operator =(thread_pool const&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // runs queued tasks on the calling thread until done() returns true, so
+    // callers waiting on their own tasks help rather than block a core
+    void run_until(std::function<bool()> const& done);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    // a process wide pool with one thread per core, created on first use
+    static thread_pool& shared();
+
+    // finishes the tasks already queued, then joins the workers
+    ~thread_pool();
+};
+
+}  // namespace tom
+
+#endif  // PARSEINI_THREAD_POOL_H
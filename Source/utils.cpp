@@ -7,28 +7,28 @@
 #include <iostream>
 #include <memory>
 #include "ini_entry.h"
+#include "memory_report.h"
 
 namespace tom {
 
 std::ostream& operator <<(std::ostream& os, ini_entry const& self) {
-    os << self.key() << "=" << self.value();
+    os << self.key_view() << "=" << self.value_view();
     return os;
 }
 
 std::ostream& operator <<(std::ostream& os, ini_section const& self) {
     os << "[" << self.name << "]\n";
 
-    auto const& entries = self.entries();
+    for (auto const& entry : self.each_entry())
+        os << entry << "\n";
 
-    for (auto const& entry : entries) {
-        std::shared_ptr<ini_entry> const& ptr = entry.lock();
-        if (ptr == nullptr)
-            os << "std::weak_ptr<ini_entry>(nullptr)";
-        else
-            os << *ptr;
-        os << "\n";
-    }
+    return os;
+}
 
+std::ostream& operator <<(std::ostream& os, memory_report const& self) {
+    os << "strings=" << self.strings << " objects=" << self.objects << " nodes=" << self.nodes
+       << " buckets=" << self.buckets << " caches=" << self.caches << " shared=" << self.shared
+       << " total=" << self.total();
     return os;
 }
 
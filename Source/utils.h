@@ -2,12 +2,16 @@
 #define PARSEINI_UTILS_H
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -27,6 +31,18 @@ namespace tom {
 struct ini_entry;
 struct ini_section;
 
+// FNV-1a. Unlike std::hash it is constexpr and gives the same result in every
+// process, so it can be stored, see ini_snapshot
+constexpr std::uint64_t fnv_offset = 14695981039346656037ull;
+
+constexpr std::uint64_t fnv_append(std::uint64_t state, std::string_view text) noexcept {
+    for (char c : text) {
+        state ^= static_cast<unsigned char>(c);
+        state *= 1099511628211ull;
+    }
+    return state;
+}
+
 static std::string readfile(std::string const& filename) {
     std::string       line;
     std::ifstream     myfile(filename);
@@ -46,12 +62,120 @@ std::ostream& operator <<(std::ostream& os, ini_entry const& self);
 
 std::ostream& operator <<(std::ostream& os, ini_section const& self);
 
-template <typename T, typename K>
-T get_or_nullptr(std::unordered_map<K, T> const& map, K const& key) noexcept {
-    if (map.find(key) == map.end()) {
+// a lookup key whose hash is computed once. Callers that look up the same
+// name over and over can keep one around instead of hashing it every time.
+// The key only views its text, which must outlive it (string literals do)
+struct ini_key {
+    std::string_view text;
+    std::size_t      hash;
+
+    explicit ini_key(std::string_view text) noexcept :
+        text(text), hash(std::hash<std::string_view>{ }(text)) { }
+};
+
+// transparent hash and equality so maps keyed by std::string can be searched
+// with a std::string_view, a const char* or an ini_key without building a
+// temporary std::string. std::hash gives std::string and std::string_view the
+// same hash, so all of them find the same bucket
+struct string_hash {
+    using is_transparent = void;
+
+    std::size_t operator ()(std::string_view s) const noexcept { return std::hash<std::string_view>{ }(s); }
+
+    std::size_t operator ()(ini_key const& k) const noexcept { return k.hash; }
+};
+
+// views of the same text, such as two keys from one string_pool, are equal
+// without comparing their chars
+constexpr bool same_text(std::string_view lhs, std::string_view rhs) noexcept {
+    return lhs.size() == rhs.size() && (lhs.data() == rhs.data() || lhs == rhs);
+}
+
+struct string_equal {
+    using is_transparent = void;
+
+    bool operator ()(std::string_view lhs, std::string_view rhs) const noexcept { return same_text(lhs, rhs); }
+
+    bool operator ()(ini_key const& lhs, std::string_view rhs) const noexcept { return same_text(lhs.text, rhs); }
+
+    bool operator ()(std::string_view lhs, ini_key const& rhs) const noexcept { return same_text(lhs, rhs.text); }
+};
+
+template <typename T>
+using string_map = std::unordered_map<std::string, T, string_hash, string_equal>;
+
+// keyed by views of text stored elsewhere, which must outlive the map entry.
+// Used where the text already lives in the mapped value, so it is not stored
+// twice
+template <typename T>
+using view_map = std::unordered_map<std::string_view, T, string_hash, string_equal>;
+
+// walks the values of a map of shared_ptrs handing out references to what they
+// point at. Nothing is copied and no reference counts are touched, so it is
+// only valid while the map is not modified
+template <typename MapIterator, typename T>
+class pointee_iterator {
+    MapIterator it;
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = std::remove_const_t<T>;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = T*;
+    using reference         = T&;
+
+    pointee_iterator() = default;
+
+    explicit pointee_iterator(MapIterator it) : it(it) { }
+
+    reference operator *() const { return *it->second; }
+
+    pointer operator ->() const { return it->second.get(); }
+
+    pointee_iterator& operator ++() {
+        ++it;
+        return *this;
+    }
+
+    pointee_iterator operator ++(int) {
+        auto copy = *this;
+        ++it;
+        return copy;
+    }
+
+    bool operator ==(pointee_iterator const& rhs) const { return it == rhs.it; }
+
+    bool operator !=(pointee_iterator const& rhs) const { return it != rhs.it; }
+};
+
+template <typename MapIterator, typename T>
+class pointee_range {
+    MapIterator first;
+    MapIterator last;
+    std::size_t count;
+
+public:
+    using iterator = pointee_iterator<MapIterator, T>;
+
+    pointee_range(MapIterator first, MapIterator last, std::size_t count) :
+        first(first), last(last), count(count) { }
+
+    [[nodiscard]] iterator begin() const { return iterator{first}; }
+
+    [[nodiscard]] iterator end() const { return iterator{last}; }
+
+    [[nodiscard]] std::size_t size() const noexcept { return count; }
+
+    [[nodiscard]] bool empty() const noexcept { return count == 0; }
+};
+
+template <typename Map, typename K>
+typename Map::mapped_type get_or_nullptr(Map const& map, K const& key) noexcept {
+    auto it = map.find(key);
+    if (it == map.end()) {
         return nullptr;
     }
-    return map.at(key);
+    return it->second;
 }
 
 }  // namespace tom
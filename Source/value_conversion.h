@@ -0,0 +1,90 @@
+#ifndef PARSEINI_VALUE_CONVERSION_H
+#define PARSEINI_VALUE_CONVERSION_H
+
+#include <charconv>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace tom {
+
+// the types convert_value handles. Character types are left out, they are
+// read as a single character rather than as a number
+template <typename T>
+inline constexpr bool is_convertible_value_v =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, signed char>
+    && !std::is_same_v<T, unsigned char> && !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char8_t>
+    && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+namespace detail {
+
+constexpr bool is_space(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+constexpr std::string_view trim(std::string_view text) noexcept {
+    while (!text.empty() && is_space(text.front()))
+        text.remove_prefix(1);
+    while (!text.empty() && is_space(text.back()))
+        text.remove_suffix(1);
+    return text;
+}
+
+constexpr bool equals_lower(std::string_view text, std::string_view lower) noexcept {
+    if (text.size() != lower.size())
+        return false;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        char const c = text[i] >= 'A' && text[i] <= 'Z' ? static_cast<char>(text[i] - 'A' + 'a') : text[i];
+        if (c != lower[i])
+            return false;
+    }
+    return true;
+}
+
+}  // namespace detail
+
+// converts text to out with std::from_chars, so without allocating or looking
+// at the locale. Surrounding whitespace is ignored, anything else that is not
+// part of the number is an error. bool accepts 1/0, true/false, yes/no and
+// on/off in any case. out is only written on success
+template <typename T>
+std::errc convert_value(std::string_view text, T& out) noexcept {
+    static_assert(is_convertible_value_v<T>, "convert_value only converts to integral, floating point and bool");
+
+    text = detail::trim(text);
+
+    if constexpr (std::is_same_v<T, bool>) {
+        for (auto word : {"1", "true", "yes", "on"}) {
+            if (detail::equals_lower(text, word)) {
+                out = true;
+                return std::errc{ };
+            }
+        }
+        for (auto word : {"0", "false", "no", "off"}) {
+            if (detail::equals_lower(text, word)) {
+                out = false;
+                return std::errc{ };
+            }
+        }
+        return std::errc::invalid_argument;
+    } else {
+        // from_chars does not take the + stream extraction allows
+        if (text.size() > 1 && text.front() == '+' && text[1] != '-')
+            text.remove_prefix(1);
+
+        T          converted{ };
+        auto const end    = text.data() + text.size();
+        auto const result = std::from_chars(text.data(), end, converted);
+        if (result.ec != std::errc{ })
+            return result.ec;
+        if (result.ptr != end)
+            return std::errc::invalid_argument;
+
+        out = converted;
+        return std::errc{ };
+    }
+}
+
+}  // namespace tom
+
+#endif  // PARSEINI_VALUE_CONVERSION_H
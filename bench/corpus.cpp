@@ -0,0 +1,94 @@
+#include "corpus.h"
+
+namespace tom::bench {
+
+namespace {
+
+// splitmix64, fully specified unlike the std distributions
+struct random_source {
+    std::uint64_t state;
+
+    std::uint64_t next() noexcept {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    bool chance(double p) noexcept {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53 < p;
+    }
+
+    std::size_t below(std::size_t n) noexcept {
+        return n == 0 ? 0 : static_cast<std::size_t>(next() % n);
+    }
+};
+
+void append_word(std::string& out, random_source& random, std::size_t length) {
+    static constexpr char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-./";
+    for (std::size_t i = 0; i < length; i++)
+        out += letters[random.below(sizeof letters - 1)];
+}
+
+// about length long, so lines do not all look alike
+std::size_t vary(random_source& random, std::size_t length) {
+    return length == 0 ? 0 : length / 2 + random.below(length + 1);
+}
+
+void append_space(std::string& out, random_source& random, double whitespace) {
+    if (random.chance(whitespace))
+        out.append(1 + random.below(4), random.chance(0.5) ? ' ' : '\t');
+}
+
+void append_line_end(std::string& out, random_source& random, corpus_options const& options) {
+    out += '\n';
+    if (random.chance(options.whitespace))
+        out += '\n';
+    if (random.chance(options.comment_density)) {
+        append_space(out, random, options.whitespace);
+        out += random.chance(0.5) ? "# " : "; ";
+        append_word(out, random, vary(random, options.value_length));
+        out += '\n';
+    }
+}
+
+}  // namespace
+
+std::string generate_corpus(corpus_options const& options) {
+    random_source random{options.seed};
+    std::string   out{ };
+    out.reserve(options.target_bytes + 4096);
+
+    out += "; generated corpus ";
+    out += options.name;
+    out += '\n';
+
+    for (std::size_t section = 0; out.size() < options.target_bytes; section++) {
+        append_space(out, random, options.whitespace);
+        out += "[Section-" + std::to_string(section) + "]";
+        append_line_end(out, random, options);
+
+        for (std::size_t key = 0; key < options.keys_per_section; key++) {
+            append_space(out, random, options.whitespace);
+            // the same key in every thirteenth section
+            random_source name_source{options.seed ^ (key * 13 + section % 13)};
+            out += "Key" + std::to_string(key) + "_" + std::to_string(section % 13) + "_";
+            append_word(out, name_source, options.key_length > 8 ? options.key_length - 8 : 1);
+            out += '=';
+
+            if (key % 4 == 0)
+                out += std::to_string(random.below(1000000));
+            else
+                append_word(out, random, vary(random, options.value_length));
+
+            if (random.chance(options.comment_density)) {
+                out += " # ";
+                append_word(out, random, vary(random, options.value_length / 2));
+            }
+            append_line_end(out, random, options);
+        }
+    }
+    return out;
+}
+
+}  // namespace tom::bench
@@ -0,0 +1,33 @@
+#ifndef PARSEINI_BENCH_CORPUS_H
+#define PARSEINI_BENCH_CORPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tom::bench {
+
+// the shape of a generated ini file. The same options always give the same
+// bytes, on every platform
+struct corpus_options {
+    std::string   name             = "default";
+    std::uint64_t seed             = 1;
+    // sections are added until the file is at least this long
+    std::size_t   target_bytes     = 1 << 20;
+    std::size_t   keys_per_section = 16;
+    std::size_t   key_length       = 12;
+    std::size_t   value_length     = 24;
+    // chance that a line is followed by a comment line, and that an entry
+    // has a comment after its value
+    double        comment_density  = 0.1;
+    // chance that a line is indented or followed by a blank line
+    double        whitespace       = 0.1;
+};
+
+// key i is named the same in every thirteenth section, so some keys are
+// defined by many sections. Every fourth value is an integer, for adapt_value
+std::string generate_corpus(corpus_options const& options);
+
+}  // namespace tom::bench
+
+#endif  // PARSEINI_BENCH_CORPUS_H
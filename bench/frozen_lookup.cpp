@@ -0,0 +1,78 @@
+// compares lookups on an ini_file with the same lookups on its frozen copy.
+// Usage: frozenbench [sections] [keys per section] [lookups]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../Source/frozen_ini_file.h"
+#include "../Source/ini_entry.h"
+#include "../Source/ini_file.h"
+
+namespace {
+
+template <typename Lookup>
+double nanoseconds_per_lookup(std::size_t lookups, Lookup lookup) {
+    auto const start = std::chrono::steady_clock::now();
+    lookup();
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(lookups);
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+    std::size_t const section_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    std::size_t const key_count     = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+    std::size_t const lookups       = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 2000000;
+
+    tom::ini_file file{"bench"};
+    for (std::size_t s = 0; s < section_count; s++) {
+        auto const name = "Section-" + std::to_string(s);
+        file.add_section(name, nullptr);
+        auto section = file.get_section(name);
+        for (std::size_t k = 0; k < key_count; k++)
+            section->add_entry("Key" + std::to_string(k) + "_" + std::to_string(s % 7), "value " + std::to_string(k));
+    }
+
+    auto const frozen = file.freeze();
+
+    // the same random (section, key) pairs for both, a few of them missing
+    std::mt19937_64                                  random{42};
+    std::vector<std::pair<std::string, std::string>> queries{ };
+    for (std::size_t i = 0; i < 4096; i++) {
+        auto const s = random() % (section_count + section_count / 16 + 1);
+        auto const k = random() % key_count;
+        queries.emplace_back("Section-" + std::to_string(s), "Key" + std::to_string(k) + "_" + std::to_string(s % 7));
+    }
+
+    std::size_t found_tree = 0, found_frozen = 0;
+
+    double const tree = nanoseconds_per_lookup(lookups, [&] {
+        for (std::size_t i = 0; i < lookups; i++) {
+            auto const& [section_name, key] = queries[i % queries.size()];
+            if (auto section = file.get_section(std::string_view{section_name}))
+                found_tree += section->get_entry(std::string_view{key}) != nullptr;
+        }
+    });
+
+    double const frozen_time = nanoseconds_per_lookup(lookups, [&] {
+        for (std::size_t i = 0; i < lookups; i++) {
+            auto const& [section_name, key] = queries[i % queries.size()];
+            found_frozen += static_cast<bool>(frozen.get_entry(frozen.get_section(section_name), key));
+        }
+    });
+
+    if (found_tree != found_frozen) {
+        std::cerr << "frozen lookups disagree with the file: " << found_frozen << " != " << found_tree << "\n";
+        return 1;
+    }
+
+    std::cout << "sections=" << section_count << " keys_per_section=" << key_count << " lookups=" << lookups << "\n"
+              << "ini_file         " << tree << " ns/lookup\n"
+              << "frozen_ini_file  " << frozen_time << " ns/lookup\n"
+              << "speedup          " << tree / frozen_time << "x\n";
+    return 0;
+}
@@ -0,0 +1,437 @@
+// throughput and latency benchmarks over generated corpora. Results are
+// written as JSON lines, one per measurement, so runs can be diffed.
+//
+// Usage: parsebench [--quick] [--runs N] [--out FILE] [--write-corpus DIR]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <malloc.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "../Source/frozen_ini_file.h"
+#include "../Source/ini_entry.h"
+#include "../Source/ini_file.h"
+#include "../Source/ini_handler.h"
+#include "../Source/ini_parser.h"
+#include "../Source/ini_writer.h"
+
+// heap bytes in use while counting is on, for the memory measurements
+std::atomic<bool>        counting_allocations{false};
+std::atomic<std::size_t> live_heap_bytes{0};
+
+void* operator new(std::size_t size) {
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+        throw std::bad_alloc{ };
+    if (counting_allocations.load(std::memory_order_relaxed))
+        live_heap_bytes += malloc_usable_size(memory);
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory != nullptr && counting_allocations.load(std::memory_order_relaxed))
+        live_heap_bytes -= malloc_usable_size(memory);
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    operator delete(memory);
+}
+
+namespace {
+
+using tom::bench::corpus_options;
+
+struct settings {
+    bool        quick = false;
+    int         runs  = 5;
+    std::string out_path{ };
+    std::string corpus_dir{ };
+};
+
+// one line of output: the median and best of runs
+class reporter {
+    std::ostream& out;
+
+public:
+    explicit reporter(std::ostream& out) : out(out) { }
+
+    void report(std::string const& benchmark, std::string const& corpus, char const* unit,
+                std::vector<double> values, bool higher_is_better) {
+        std::sort(values.begin(), values.end());
+        double const median = values[values.size() / 2];
+        double const best   = higher_is_better ? values.back() : values.front();
+
+        out << "{\"benchmark\":\"" << benchmark << "\",\"corpus\":\"" << corpus << "\",\"unit\":\"" << unit
+            << "\",\"median\":" << median << ",\"best\":" << best << ",\"runs\":" << values.size() << "}\n";
+        std::cerr << "  " << benchmark << " " << median << " " << unit << "\n";
+    }
+};
+
+template <typename Work>
+std::vector<double> seconds(int runs, Work work) {
+    std::vector<double> times{ };
+    for (int i = 0; i < runs; i++) {
+        auto const start = std::chrono::steady_clock::now();
+        work();
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return times;
+}
+
+std::vector<double> per_second(std::vector<double> times, double amount) {
+    for (auto& time : times)
+        time = amount / time;
+    return times;
+}
+
+std::vector<double> nanoseconds_each(std::vector<double> times, double count) {
+    for (auto& time : times)
+        time = time * 1e9 / count;
+    return times;
+}
+
+// keeps the optimizer from dropping work whose result is unused
+volatile std::size_t sink = 0;
+
+void consume(std::size_t value) {
+    sink = sink + value;
+}
+
+struct counting_handler final : tom::ini_handler {
+    std::size_t entries = 0;
+
+    bool on_entry(std::string_view, std::string_view) override {
+        entries++;
+        return true;
+    }
+};
+
+void parse_benchmarks(reporter& results, settings const& options, std::string const& corpus, std::string const& path,
+                      double megabytes) {
+    using tom::input_mode;
+
+    results.report("parse.buffered", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_parser parser{path};
+        consume(parser.parse().sections().size());
+    }), megabytes), true);
+
+    results.report("parse.mapped", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_parser parser{path, {'#', ';'}, '\n', input_mode::mapped};
+        consume(parser.parse().sections().size());
+    }), megabytes), true);
+
+    tom::read_ahead_stats waited{ };
+    results.report("parse.read_ahead", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        auto parser = tom::ini_parser::with_read_ahead(path, {.block_size = 256 << 10, .blocks = 3});
+        consume(parser.parse().sections().size());
+        waited = parser.io_stats();
+    }), megabytes), true);
+    results.report("parse.read_ahead_waiting", corpus, "us", std::vector<double>{
+        std::chrono::duration<double, std::micro>(waited.waited).count()
+    }, false);
+
+    // the same text from memory, with and without the refill loop
+    std::string text{ };
+    {
+        std::ifstream in{path, std::ios::binary};
+        text.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{ });
+    }
+
+    results.report("parse.from_buffer", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        consume(tom::ini_parser::from_buffer(text).parse().sections().size());
+    }), megabytes), true);
+
+    results.report("parse.from_stream", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        std::istringstream in{text};
+        consume(tom::ini_parser::from_stream(in).parse().sections().size());
+    }), megabytes), true);
+
+    // the same lines ended with "\r\n", parsed with a "\r\n" terminator
+    std::string crlf{ };
+    crlf.reserve(text.size() + text.size() / 16);
+    for (char c : text) {
+        if (c == '\n')
+            crlf += '\r';
+        crlf += c;
+    }
+    std::string const crlf_path = path + ".crlf";
+    std::ofstream{crlf_path, std::ios::binary} << crlf;
+    double const           crlf_megabytes = static_cast<double>(crlf.size()) / (1024 * 1024);
+    tom::ini_syntax const  crlf_syntax{{"#", ";"}, "\r\n"};
+
+    results.report("parse.crlf_buffered", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_parser parser{crlf_path, crlf_syntax};
+        consume(parser.parse().sections().size());
+    }), crlf_megabytes), true);
+
+    results.report("parse.crlf_mapped", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_parser parser{crlf_path, crlf_syntax, input_mode::mapped};
+        consume(parser.parse().sections().size());
+    }), crlf_megabytes), true);
+    std::filesystem::remove(crlf_path);
+
+    results.report("parse.arena", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_parser parser{path, {'#', ';'}, '\n', input_mode::mapped};
+        consume(parser.parse_arena().section_count());
+    }), megabytes), true);
+
+    results.report("parse.handler", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_parser  parser{path, {'#', ';'}, '\n', input_mode::mapped};
+        counting_handler handler{ };
+        parser.parse(handler);
+        consume(handler.entries);
+    }), megabytes), true);
+
+    results.report("parse.parallel", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_parser parser{path, {'#', ';'}, '\n', input_mode::mapped};
+        consume(parser.parse_parallel(0, 64 * 1024).sections().size());
+    }), megabytes), true);
+}
+
+struct continuing_handler final : tom::ini_handler {
+    std::size_t errors = 0;
+
+    bool on_error(tom::parse_error const&) override {
+        errors++;
+        return true;
+    }
+};
+
+// linting text with every tenth line broken, through exceptions and on_error
+// or by collecting diagnostics
+void diagnostic_benchmarks(reporter& results, settings const& options, std::string const& corpus,
+                           std::string const& text) {
+    std::string broken{ };
+    broken.reserve(text.size());
+    std::size_t line = 0;
+    for (std::size_t at = 0; at < text.size();) {
+        auto end = text.find('\n', at);
+        end      = end == std::string::npos ? text.size() : end + 1;
+        if (++line % 10 == 0 && text[at] != '[')
+            broken += "not an entry\n";
+        else
+            broken.append(text, at, end - at);
+        at = end;
+    }
+    double const megabytes = static_cast<double>(broken.size()) / (1024 * 1024);
+
+    results.report("lint.on_error", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        continuing_handler handler{ };
+        tom::ini_parser::from_buffer(broken).parse(handler);
+        consume(handler.errors);
+    }), megabytes), true);
+
+    results.report("lint.collecting", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        tom::ini_handler                   nothing{ };
+        std::vector<tom::parse_diagnostic> found{ };
+        tom::ini_parser::from_buffer(broken).parse(nothing, found);
+        consume(found.size());
+    }), megabytes), true);
+}
+
+// heap held by a batch of copies of one file, each owning its keys or all of
+// them sharing one string pool
+void memory_benchmarks(reporter& results, std::string const& corpus, std::string const& path) {
+    constexpr std::size_t copies = 8;
+
+    auto const per_file = [&path](std::shared_ptr<tom::string_pool> const& pool) {
+        counting_allocations = true;
+        auto const before = live_heap_bytes.load();
+        double     bytes  = 0;
+        {
+            std::vector<tom::ini_file> files{ };
+            for (std::size_t i = 0; i < copies; i++) {
+                tom::ini_parser parser{path};
+                if (pool != nullptr)
+                    parser.use_string_pool(pool);
+                files.push_back(parser.parse());
+            }
+            bytes = static_cast<double>(live_heap_bytes.load() - before);
+        }
+        counting_allocations = false;
+        return std::vector<double>{bytes / copies / 1024};
+    };
+
+    results.report("memory.owned_keys", corpus, "KB/file", per_file(nullptr), false);
+    results.report("memory.pooled_keys", corpus, "KB/file", per_file(std::make_shared<tom::string_pool>()), false);
+
+    // what the file accounts for itself, next to what was counted above
+    tom::ini_parser parser{path};
+    auto const      reported = parser.parse().memory_usage();
+    results.report("memory.reported", corpus, "KB/file",
+                   std::vector<double>{static_cast<double>(reported.total()) / 1024}, false);
+}
+
+void lookup_benchmarks(reporter& results, settings const& options, std::string const& corpus, std::string const& path) {
+    tom::ini_parser parser{path};
+    tom::ini_file   file   = parser.parse();
+    auto const      frozen = file.freeze();
+
+    // existing section and key names in a fixed order, spread over the file
+    std::vector<std::pair<std::string, std::string>> queries{ };
+    std::vector<std::shared_ptr<tom::ini_entry>>     numbers{ };
+    std::size_t                                      n = 0;
+    for (auto const& section : file.each_section()) {
+        for (auto const& entry : section.each_entry()) {
+            if (n++ % 7 == 0 && queries.size() < 4096)
+                queries.emplace_back(section.name, entry.key());
+            if (entry.key().rfind("Key0_", 0) == 0 && numbers.size() < 4096)
+                numbers.push_back(section.get_entry(entry.key_view()));
+        }
+    }
+    if (queries.empty() || numbers.empty())
+        return;
+
+    std::size_t const lookups = options.quick ? 200000 : 2000000;
+    auto const        query   = [&queries](std::size_t i) -> auto const& {
+        return queries[(i * 2654435761u) % queries.size()];
+    };
+
+    std::vector<std::shared_ptr<tom::ini_section>> resolved{ };
+    for (auto const& [section, key] : queries)
+        resolved.push_back(file.get_section(std::string_view{section}));
+
+    results.report("lookup.get_section", corpus, "ns", nanoseconds_each(seconds(options.runs, [&] {
+        for (std::size_t i = 0; i < lookups; i++)
+            consume(file.get_section(std::string_view{query(i).first}) != nullptr);
+    }), lookups), false);
+
+    results.report("lookup.section_get_entry", corpus, "ns", nanoseconds_each(seconds(options.runs, [&] {
+        for (std::size_t i = 0; i < lookups; i++) {
+            auto const at = (i * 2654435761u) % queries.size();
+            consume(resolved[at]->get_entry(std::string_view{queries[at].second}) != nullptr);
+        }
+    }), lookups), false);
+
+    results.report("lookup.file_get_entry", corpus, "ns", nanoseconds_each(seconds(options.runs, [&] {
+        for (std::size_t i = 0; i < lookups; i++)
+            consume(file.get_entry(std::string_view{query(i).second}) != nullptr);
+    }), lookups), false);
+
+    results.report("lookup.frozen_get_entry", corpus, "ns", nanoseconds_each(seconds(options.runs, [&] {
+        for (std::size_t i = 0; i < lookups; i++) {
+            auto const& [section, key] = query(i);
+            consume(static_cast<bool>(frozen.get_entry(frozen.get_section(section), key)));
+        }
+    }), lookups), false);
+
+    results.report("convert.adapt_value_int", corpus, "ns", nanoseconds_each(seconds(options.runs, [&] {
+        for (std::size_t i = 0; i < lookups; i++)
+            consume(numbers[i % numbers.size()]->adapt_value<int>());
+    }), lookups), false);
+
+    results.report("convert.cached_value_int", corpus, "ns", nanoseconds_each(seconds(options.runs, [&] {
+        for (std::size_t i = 0; i < lookups; i++)
+            consume(numbers[i % numbers.size()]->cached_value<int>());
+    }), lookups), false);
+
+    // what adapt_value cost before it used from_chars
+    results.report("convert.stringstream_int", corpus, "ns", nanoseconds_each(seconds(options.runs, [&] {
+        for (std::size_t i = 0; i < lookups / 10; i++) {
+            std::stringstream stream(numbers[i % numbers.size()]->value());
+            int               x = 0;
+            stream >> x;
+            consume(x);
+        }
+    }), lookups / 10), false);
+
+    std::ostringstream probe{ };
+    probe << file;
+    double const output_megabytes = static_cast<double>(probe.str().size()) / (1024 * 1024);
+    results.report("serialize.ostream", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        std::ostringstream out{ };
+        out << file;
+        consume(out.str().size());
+    }), output_megabytes), true);
+
+    // both write to /dev/null so only formatting and syscalls are measured
+    results.report("serialize.ofstream", corpus, "MB/s", per_second(seconds(options.runs, [&] {
+        std::ofstream out{"/dev/null"};
+        out << file;
+    }), output_megabytes), true);
+
+    int const null_fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    for (auto [name, order] : {std::pair{"serialize.writer_unordered", tom::write_order::unordered},
+                               std::pair{"serialize.writer_insertion", tom::write_order::insertion},
+                               std::pair{"serialize.writer_sorted", tom::write_order::sorted}}) {
+        results.report(name, corpus, "MB/s", per_second(seconds(options.runs, [&, order = order] {
+            tom::ini_writer writer{null_fd, {.order = order}};
+            writer.write(file);
+            writer.flush();
+            consume(writer.bytes_written());
+        }), output_megabytes), true);
+    }
+    ::close(null_fd);
+}
+
+std::vector<corpus_options> corpora(bool quick) {
+    std::size_t const big = quick ? (256 << 10) : (4 << 20);
+
+    std::vector<corpus_options> all{ };
+    all.push_back(corpus_options{.name = "small", .seed = 1, .target_bytes = 64 << 10});
+    all.push_back(corpus_options{.name = "medium", .seed = 2, .target_bytes = big});
+    all.push_back(corpus_options{.name = "long-values", .seed = 3, .target_bytes = big, .keys_per_section = 8,
+                                 .key_length = 24, .value_length = 200});
+    all.push_back(corpus_options{.name = "many-sections", .seed = 4, .target_bytes = big, .keys_per_section = 2});
+    all.push_back(corpus_options{.name = "comment-heavy", .seed = 5, .target_bytes = big, .comment_density = 0.6});
+    all.push_back(corpus_options{.name = "whitespace-heavy", .seed = 6, .target_bytes = big, .whitespace = 0.6});
+    return all;
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+    settings options{ };
+    for (int i = 1; i < argc; i++) {
+        std::string_view const arg = argv[i];
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--runs" && i + 1 < argc) {
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--out" && i + 1 < argc) {
+            options.out_path = argv[++i];
+        } else if (arg == "--write-corpus" && i + 1 < argc) {
+            options.corpus_dir = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--quick] [--runs N] [--out FILE] [--write-corpus DIR]\n";
+            return 2;
+        }
+    }
+
+    std::ofstream file_out{ };
+    if (!options.out_path.empty())
+        file_out.open(options.out_path);
+    reporter results{options.out_path.empty() ? std::cout : file_out};
+
+    auto const directory = options.corpus_dir.empty() ? std::filesystem::temp_directory_path()
+                                                      : std::filesystem::path{options.corpus_dir};
+    std::filesystem::create_directories(directory);
+
+    for (auto const& corpus : corpora(options.quick)) {
+        auto const text = tom::bench::generate_corpus(corpus);
+        auto const path = (directory / ("parsebench-" + corpus.name + ".ini")).string();
+        std::ofstream{path, std::ios::binary} << text;
+
+        std::cerr << corpus.name << " (" << text.size() << " bytes)\n";
+        parse_benchmarks(results, options, corpus.name, path, static_cast<double>(text.size()) / (1024 * 1024));
+        lookup_benchmarks(results, options, corpus.name, path);
+        memory_benchmarks(results, corpus.name, path);
+        diagnostic_benchmarks(results, options, corpus.name, text);
+
+        if (options.corpus_dir.empty())
+            std::filesystem::remove(path);
+    }
+    return 0;
+}
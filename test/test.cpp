@@ -1,15 +1,50 @@
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <istream>
+#include <iterator>
+#include <optional>
+#include <sstream>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 #include "../Source/ini_entry.h"
 #include "../Source/ini_file.h"
 #include "../Source/ini_parser.h"
 #include "../Source/utils.h"
+#include "../Source/char_scanner.h"
+#include "../Source/batch_parse.h"
+#include "../Source/ini_watcher.h"
+#include "../Source/ini_schema.h"
+#include "../Source/ini_snapshot.h"
+#include "../Source/frozen_ini_file.h"
+#include "../Source/ini_writer.h"
+#include "../Source/ini_document.h"
+#include "../Source/rcu_holder.h"
 #include <type_traits>
 
 namespace {
+struct server_config {
+    int         ftp_port = 0;
+    std::string ftp_dir{ };
+    bool        use_snmp = false;
+    double      timeout  = 0;
+    std::string contact{ };
+};
+
+constexpr auto server_schema = tom::make_schema(
+    tom::required("FTP", "FTPPort", &server_config::ftp_port),
+    tom::required("FTP", "FTPDir", &server_config::ftp_dir),
+    tom::field("SNMP", "UseSNMP", &server_config::use_snmp, false),
+    tom::field("FTP", "Timeout", &server_config::timeout, 2.5),
+    tom::required("FTP", "Contact", &server_config::contact)
+);
+
 inline std::string quote(std::string const& s) {
     return "\"" + s + "\"";
 }
@@ -46,12 +81,480 @@ int main(int argc, char const* argv[]) {
     std::cout << "Setting " << quote(entry->key()) << " has value() " << quote(entry->value()) << " in section "
               << quote(entry->parent.lock()->name) << "\n";
 
+    // string_view and precomputed key lookups find the same entries
+    tom::ini_key const ftp_port_key{"FTPPort"};
+    assert(f.get_section(std::string_view{"FTP"})->get_entry(ftp_port_key) == port);
+    assert(f.get_section(tom::ini_key{"FTP"}) == section);
+    assert(f.get_entry(tom::ini_key{"PrimaryIP"}) == entry);
+
     std::cout << "Value = " << port->adapt_value<int>() << std::endl;
 
     auto const ftp_port = f.get_section("FTP")->get_entry("FTPPort")->adapt_value<short>();
     auto const ftps     = f["FTP"]["FTPPort"];
     std::cout << "Port: " << ftp_port << std::endl;
 
+    // typed reads report bad values instead of returning 0, and a cached read
+    // follows the value when it changes
+    {
+        tom::ini_entry typed{{ }, "Typed", "  8080 "};
+        int            out = 0;
+        assert(typed.try_adapt_value(out) == std::errc{ } && out == 8080);
+        assert(typed.cached_value<int>() == 8080);
+
+        typed.set_value("70000");
+        short narrow = 0;
+        assert(typed.try_adapt_value(narrow) == std::errc::result_out_of_range);
+        assert(typed.cached_value<int>() == 70000);
+
+        typed.set_value("off");
+        assert(!typed.cached_value<bool>());
+        assert(typed.try_adapt_value(out) == std::errc::invalid_argument && out == 8080);
+
+        bool threw = false;
+        try {
+            (void) typed.adapt_value<double>();
+        } catch (std::invalid_argument const&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // the mapped mode must produce the same values without owning them
+    {
+        tom::ini_parser mapped_parser{argv[1], {'#', ';'}, '\n', tom::input_mode::mapped};
+        tom::ini_file   mapped = mapped_parser.parse();
+
+        auto mapped_port = mapped.get_section("FTP")->get_entry("FTPPort");
+        assert(mapped_port->is_borrowed());
+        assert(mapped_port->value_view() == "21");
+        assert(mapped_port->value() == port->value());
+        assert(mapped.get_entry("PrimaryIP")->value_view() == "192.168.0.13");
+    }
+
+    // a copy of a mapped entry owns its text and outlives the mapping
+    {
+        std::optional<tom::ini_entry> copied{ };
+        {
+            tom::ini_parser mapped_parser{argv[1], {'#', ';'}, '\n', tom::input_mode::mapped};
+            tom::ini_file   mapped = mapped_parser.parse();
+            copied.emplace(*mapped.get_section("FTP")->get_entry("FTPPort"));
+        }
+        assert(!copied->is_borrowed());
+        assert(copied->key() == "FTPPort" && copied->value() == "21");
+    }
+
+    // the arena backed model must hold the same values as the ini_file
+    {
+        tom::ini_parser     arena_parser{argv[1]};
+        tom::arena_ini_file arena = arena_parser.parse_arena();
+
+        auto ftp = arena.get_section("FTP");
+        assert(ftp);
+        assert(arena.value(arena.get_entry(ftp, "FTPPort")) == "21");
+        assert(arena.value(arena.get_entry("PrimaryIP")) == "192.168.0.13");
+        assert(arena.section_count() == f.sections().size());
+    }
+
+    // a parallel parse cut into small pieces must build the same file
+    {
+        tom::ini_parser parallel_parser{argv[1]};
+        tom::ini_file   parallel = parallel_parser.parse_parallel(4, 1024);
+
+        assert(parallel.sections().size() == f.sections().size());
+        assert(parallel.get_section("FTP")->get_entry("FTPPort")->value() == "21");
+        assert(parallel.get_entry("PrimaryIP")->value() == "192.168.0.13");
+    }
+
+    // a batch parses each file on its own and shares the keys between them
+    {
+        auto batch = tom::parse_many({argv[1], argv[1], "does/not/exist.ini"});
+
+        assert(batch.size() == 3);
+        assert(batch[0] && batch[1] && !batch[2] && batch[2].error != nullptr);
+
+        // a missing file throws in the buffered mode too, not an empty file
+        bool missing = false;
+        try {
+            tom::ini_parser{"does/not/exist.ini"}.parse();
+        } catch (std::system_error const& error) {
+            missing = error.code() == std::errc::no_such_file_or_directory;
+        }
+        assert(missing);
+        assert(batch[1].file->get_section("FTP")->get_entry("FTPPort")->value() == "21");
+        assert(batch[0].file->get_entry("PrimaryIP")->key_view().data()
+               == batch[1].file->get_entry("PrimaryIP")->key_view().data());
+
+        // keys added later go to the same pool, and replacing a key keeps it findable
+        auto& pooled = *batch[0].file;
+        pooled.get_section("FTP")->add_entry("PrimaryIP", "10.0.0.1");
+        assert(pooled.get_section("FTP")->get_entry("PrimaryIP")->key_view().data()
+               == batch[1].file->get_entry("PrimaryIP")->key_view().data());
+        pooled.get_section("FTP")->add_entry("PrimaryIP", "10.0.0.2");
+        pooled.get_section("FTP")->remove_entry("FTPPort");
+        assert(pooled.get_section("FTP")->get_value("PrimaryIP").first == "10.0.0.2");
+        for (auto const& defining : pooled.sections_defining("PrimaryIP"))
+            assert(defining->get_entry("PrimaryIP") != nullptr);
+    }
+
+    // buffers, streams and descriptors parse to the same file as the filename
+    {
+        std::ifstream     in{argv[1], std::ios::binary};
+        std::string const text{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{ }};
+        auto const        from_file = tom::ini_parser{argv[1]}.parse();
+
+        std::istringstream source{text};
+        int const          fd = ::open(argv[1], O_RDONLY | O_CLOEXEC);
+        assert(fd >= 0);
+        auto const parsed = std::array{
+            tom::ini_parser::from_buffer(text).parse(),
+            tom::ini_parser::from_stream(source).parse(),
+            tom::ini_parser::from_fd(fd).parse(),
+        };
+        ::close(fd);
+        for (auto const& each : parsed) {
+            assert(each.sections().size() == from_file.sections().size());
+            assert(each.get_section("FTP")->get_value("FTPPort") == from_file.get_section("FTP")->get_value("FTPPort"));
+        }
+        assert(parsed[0].name == "<buffer>");
+
+        // positions count from the start of whatever was given
+        try {
+            tom::ini_parser::from_buffer("[A]\nkey=value\n[unterminated\n", "inline").parse();
+            assert(false);
+        } catch (tom::parse_error const& error) {
+            assert(std::string{error.what()}.find("inline has failed at line: 3, col: 0 (14)") != std::string::npos);
+        }
+    }
+
+    // reading ahead in small blocks, on another thread or not, parses the same file
+    {
+        auto const from_file = tom::ini_parser{argv[1]}.parse();
+        auto const size      = std::filesystem::file_size(argv[1]);
+        for (std::size_t blocks : {1, 2, 4}) {
+            auto       parser = tom::ini_parser::with_read_ahead(argv[1], {.block_size = 16, .blocks = blocks});
+            auto const parsed = parser.parse();
+            assert(parsed.sections().size() == from_file.sections().size());
+            assert(parsed.get_section("FTP")->get_value("FTPDir") == from_file.get_section("FTP")->get_value("FTPDir"));
+            assert(parser.io_stats().bytes == size);
+            assert(parser.io_stats().blocks == (size + 15) / 16);
+        }
+        assert(tom::ini_parser{argv[1]}.io_stats().blocks == 0);
+    }
+
+    // dotted section names form a tree that can be queried by prefix
+    {
+        auto tree = tom::ini_parser::from_buffer("[servers]\nport=21\n[servers.eu]\nregion=eu\n"
+                                                 "[servers.eu.db2]\n[servers.eu.db1]\nport=5432\n"
+                                                 "[servers.us.db3]\n[serversX]\n").parse();
+
+        std::vector<std::string> names{ };
+        for (auto const& section : tree.sections_under("servers.eu"))
+            names.push_back(section->name);
+        assert((names == std::vector<std::string>{"servers.eu", "servers.eu.db1", "servers.eu.db2"}));
+        assert(tree.sections_under("servers").size() == 5);
+        assert(tree.sections_under("servers.e").empty());
+
+        std::size_t visited = 0;
+        tree.each_section_under("servers.us", [&visited](tom::ini_section const&) { visited++; });
+        assert(visited == 1);
+
+        // lookups fall back to the closest section above, skipping missing levels
+        assert(tree.parent_section("servers.us.db3")->name == "servers");
+        assert(tree.parent_section("servers") == nullptr);
+        assert(tree.get_inherited_entry("servers.eu.db1", "port")->value() == "5432");
+        assert(tree.get_inherited_entry("servers.eu.db2", "port")->value() == "21");
+        assert(tree.get_section("servers.eu.db2")->get_inherited_entry("region")->value() == "eu");
+        assert(tree.get_inherited_entry("serversX", "port") == nullptr);
+
+        tree.remove_section("servers.eu");
+        assert(tree.get_inherited_entry("servers.eu.db2", "region") == nullptr);
+        assert(tree.sections_under("servers.eu").size() == 2);
+        tree.remove_section("servers.eu.db1");
+        tree.remove_section("servers.eu.db2");
+        assert(tree.sections_under("servers.eu").empty());
+    }
+
+    // CRLF terminators and multi char comment openers, in every input mode
+    {
+        std::string text = "// leading comment\r\n[paths]\r\nroot=/usr/a/b\r\nrange=1-2 -- the range\r\n"
+                           "\r\n[plain]\nlf=only\n# hash\r\n";
+        // push a '/' and a '-' right up against the ends of small blocks
+        for (int i = 0; i < 40; i++)
+            text += "k" + std::to_string(i) + "=" + std::string(static_cast<std::size_t>(i % 7), 'x') + "/-/\r\n";
+
+        tom::ini_syntax const syntax{{"//", "--", "#"}, "\r\n"};
+        auto const check = [](tom::ini_file const& file) {
+            assert(file.get_section("paths")->get_value("root").first == "/usr/a/b");
+            assert(file.get_section("paths")->get_value("range").first == "1-2 ");
+            assert(file.get_section("plain")->get_value("lf").first == "only");
+            assert(file.get_section("plain")->get_value("k39").first == "xxxx/-/");
+        };
+        check(tom::ini_parser::from_buffer(text, "crlf", syntax).parse());
+
+        std::filesystem::path const crlf_path = std::filesystem::temp_directory_path() / "parseini_crlf.ini";
+        std::ofstream{crlf_path, std::ios::binary} << text;
+        check(tom::ini_parser{crlf_path.string(), syntax}.parse());
+        check(tom::ini_parser{crlf_path.string(), syntax, tom::input_mode::mapped}.parse());
+        check(tom::ini_parser::with_read_ahead(crlf_path.string(), {.block_size = 7, .blocks = 3}, syntax).parse());
+        std::filesystem::remove(crlf_path);
+
+        // the single char syntax is unchanged and keeps the '\r'
+        assert(tom::ini_parser::from_buffer("[a]\r\nk=v\r\n").parse().get_section("a")->get_value("k").first
+               == "v\r");
+    }
+
+    // collecting finds every problem in one pass and keeps what parsed
+    {
+        auto const result = tom::ini_parser::from_buffer("[a]\nk=v\nbad line\n[]\nk2=v2\nanother bad\n[open",
+                                                         "lint").parse_collecting();
+        assert(!result);
+        assert(result.diagnostics.size() == 4);
+        assert(result.diagnostics[0].kind == tom::diagnostic_kind::malformed_line);
+        assert(result.diagnostics[1].kind == tom::diagnostic_kind::empty_section_name);
+        assert(result.diagnostics[2].kind == tom::diagnostic_kind::malformed_line);
+        assert(result.diagnostics[3].kind == tom::diagnostic_kind::unterminated_section);
+        assert(result.diagnostics[0].line == 3 && result.diagnostics[0].column == 8);
+        assert(result.diagnostics[3].line == 7 && result.diagnostics[3].offset == 38);
+        assert(result.file.get_section("a")->get_value("k2").first == "v2");
+
+        // a problem is reported on its own line, and a section header does
+        // not run into the lines after it
+        auto const malformed = tom::ini_parser::from_buffer("[a]\nk=v\nbadline\n# note\nx=y\n").parse_collecting();
+        assert(malformed.diagnostics.size() == 1 && malformed.diagnostics[0].line == 3);
+        assert(malformed.diagnostics[0].offset == 15);
+        assert(malformed.file.get_section("a")->get_value("x").first == "y");
+
+        auto const open = tom::ini_parser::from_buffer("[open\nk=v\n[b]\nz=1").parse_collecting();
+        assert(open.diagnostics.size() == 1);
+        assert(open.diagnostics[0].kind == tom::diagnostic_kind::unterminated_section);
+        assert(open.diagnostics[0].line == 1 && open.diagnostics[0].column == 0);
+        assert(open.file.get_entry("k") != nullptr && open.file.get_section("b")->get_value("z").first == "1");
+
+        // the text is what parse() throws
+        try {
+            tom::ini_parser::from_buffer("[a]\n[]\n", "lint").parse();
+            assert(false);
+        } catch (tom::empty_section_name const& error) {
+            auto const collected = tom::ini_parser::from_buffer("[a]\n[]\n", "lint").parse_collecting();
+            assert(collected.diagnostics.size() == 1);
+            assert(collected.diagnostics[0].message("lint") == error.what());
+        }
+
+        // validating only, without a tree
+        tom::ini_handler                   nothing{ };
+        std::vector<tom::parse_diagnostic> found{ };
+        assert(tom::ini_parser::from_buffer("ok=1\nnot ok\n").parse(nothing, found));
+        assert(found.size() == 1);
+        assert(tom::ini_parser{argv[1]}.parse_collecting());
+    }
+
+    // memory_usage counts sections, entries and text, a file more than its sections
+    {
+        auto       accounted = tom::ini_parser{argv[1]}.parse();
+        auto const before    = accounted.memory_usage();
+        assert(before.objects > 0 && before.nodes > 0 && before.total() > 0);
+
+        tom::memory_report sections{ };
+        for (auto const& section : accounted.each_section())
+            sections += section.memory_usage();
+        assert(before.total() > sections.total());
+
+        accounted.get_section("FTP")->add_entry("Banner", std::string(4096, 'x'));
+        auto const after = accounted.memory_usage();
+        assert(after.strings >= before.strings + 4096);
+        assert(after.objects > before.objects);
+    }
+
+    // a schema binds values straight into a struct and reports what it could not
+    {
+        server_config config{ };
+        auto          schema_parser = tom::ini_parser::from_buffer(
+            "[FTP]\nFTPPort=21\nFTPDir=/srv/ftp\nBanner=hi\n[SNMP]\nUseSNMP=yes\n");
+        auto const report = tom::parse_into(schema_parser, server_schema, config);
+
+        assert(config.ftp_port == 21 && config.use_snmp && config.timeout == 2.5);
+        assert(config.ftp_dir == "/srv/ftp");
+        assert(report.missing.size() == 1 && report.missing[0].key == "Contact");
+        assert(report.invalid.empty() && report.unknown.size() == 1 && report.unknown[0].key == "Banner");
+
+        // a section that appears again takes the issues of the first with it
+        server_config replaced{ };
+        auto          replacing = tom::ini_parser::from_buffer(
+            "[FTP]\nFTPPort=many\nOld=1\n[FTP]\nFTPPort=2121\nFTPDir=/d\nContact=ops\n");
+        assert(tom::parse_into(replacing, server_schema, replaced).ok() && replaced.ftp_port == 2121);
+    }
+
+    // a snapshot answers lookups from its image the same way the file does
+    {
+        auto const image = std::filesystem::temp_directory_path() / "parsetest.snapshot";
+        std::filesystem::remove(image);
+
+        auto const built  = tom::ini_snapshot::load_or_build(argv[1], image.string());
+        auto const loaded = tom::ini_snapshot::load_or_build(argv[1], image.string());
+        assert(loaded.matches(argv[1]) && loaded.section_count() == f.sections().size());
+        assert(loaded.get_value("FTP", "FTPPort") == std::optional<std::string_view>{"21"});
+        assert(loaded.value(loaded.get_entry("PrimaryIP")) == "192.168.0.13");
+        assert(!loaded.get_section("No Such Section"));
+
+        // damaged records read as empty rather than outside the image
+        auto const size = std::filesystem::file_size(image);
+        {
+            std::fstream damage{image, std::ios::in | std::ios::out | std::ios::binary};
+            damage.seekp(128);
+            damage << std::string(size - 128, '\xff');
+        }
+        bool rejected = false;
+        try {
+            tom::ini_snapshot{image.string()};
+        } catch (tom::snapshot_error const&) {
+            rejected = true;
+        }
+        assert(rejected);
+        tom::ini_snapshot const damaged{image.string(), false};
+        for (std::uint32_t i = 0; i < damaged.section_count(); i++) {
+            auto const section = damaged.section_at(i);
+            static_cast<void>(damaged.section_name(section));
+            for (std::uint32_t j = 0; j < damaged.entry_count(section); j++)
+                static_cast<void>(damaged.value(damaged.entry_at(section, j)));
+        }
+        static_cast<void>(damaged.get_value("FTP", "FTPPort"));
+        static_cast<void>(damaged.get_entry("PrimaryIP"));
+        std::filesystem::remove(image);
+    }
+
+    // a frozen copy finds what the file finds
+    {
+        auto const frozen = f.freeze();
+        assert(frozen.section_count() == f.sections().size());
+        assert(frozen.get_value("FTP", "FTPPort") == std::optional<std::string_view>{"21"});
+        assert(frozen.value(frozen.get_entry("PrimaryIP")) == "192.168.0.13");
+        assert(!frozen.get_section("No Such Section") && !frozen.get_entry("No Such Key"));
+    }
+
+    // a handler can pick one value out of the file and stop there
+    {
+        struct find_port final : tom::ini_handler {
+            std::string section{ };
+            std::string port{ };
+
+            bool on_section(std::string_view name) override {
+                section = name;
+                return true;
+            }
+
+            bool on_entry(std::string_view key, std::string_view value) override {
+                if (section != "FTP" || key != "FTPPort")
+                    return true;
+                port = value;
+                return false;
+            }
+        } handler;
+
+        tom::ini_parser sax_parser{argv[1]};
+        assert(!sax_parser.parse(handler));
+        assert(handler.port == "21");
+    }
+
+    // a document writes a one key change back without touching anything else
+    {
+        auto const copy = std::filesystem::temp_directory_path() / "parsetest_document.ini";
+        std::filesystem::copy_file(argv[1], copy, std::filesystem::copy_options::overwrite_existing);
+
+        tom::ini_document document{copy.string()};
+        std::string const before{document.original()};
+        assert(document.changes().empty());
+
+        document.file().get_section("FTP")->get_entry("FTPPort")->set_value("99");
+        assert(document.changes().size() == 1);
+        assert(document.save());
+
+        document.file().get_section("FTP")->add_entry("Added", "yes");
+        assert(!document.save());
+        auto reparsed = tom::ini_parser{copy.string()}.parse();
+        assert(reparsed.get_section("FTP")->get_value("FTPPort").first == "99");
+        assert(reparsed.get_section("FTP")->get_value("Added").first == "yes");
+        assert(document.original().size() == before.size() + std::string_view{"Added=yes\n"}.size());
+        std::filesystem::remove(copy);
+    }
+
+    // readers on other threads keep seeing a whole file while it is replaced,
+    // mapped files and typed reads included
+    {
+        auto const parse_mapped = [&argv] {
+            return std::make_unique<tom::ini_file>(
+                tom::ini_parser{argv[1], {'#', ';'}, '\n', tom::input_mode::mapped}.parse());
+        };
+        tom::rcu_holder<tom::ini_file> config{parse_mapped()};
+        std::atomic<bool>              done{false};
+        std::vector<std::thread>       readers{ };
+        for (int i = 0; i < 4; i++) {
+            readers.emplace_back([&config, &done] {
+                while (!done) {
+                    auto const current = config.read();
+                    auto const ftp     = current->get_section("FTP");
+                    assert(ftp->get_value("FTPPort").first == "21");
+                    assert(ftp->get_entry("FTPPort")->cached_value<int>() == 21);
+                }
+            });
+        }
+        for (int i = 0; i < 8; i++)
+            config.publish(parse_mapped());
+        done = true;
+        for (auto& reader : readers)
+            reader.join();
+        config.reclaim();
+    }
+
+    // a watched copy of the file reports only the section that was appended
+    {
+        auto const copy = std::filesystem::temp_directory_path() / "parsetest_watched.ini";
+        std::filesystem::copy_file(argv[1], copy, std::filesystem::copy_options::overwrite_existing);
+
+        tom::ini_watcher watcher{copy.string()};
+        std::ofstream{copy, std::ios::app} << "\n[Watched]\nAdded=yes\n";
+
+        auto const changes = watcher.reload();
+        assert(changes.added_sections == std::vector<std::string>{"Watched"});
+        assert(changes.removed_sections.empty() && changes.modified_sections.empty());
+        assert(watcher.last_reparsed() <= 2);
+
+        // wait() picks up the file written in place and replaced by a rename
+        std::ofstream{copy, std::ios::app} << "Second=no\n";
+        auto const written = watcher.wait(std::chrono::seconds{5});
+        assert(written && written->modified_sections == std::vector<std::string>{"Watched"});
+        assert(written->added_entries.size() == 1 && written->added_entries[0].key == "Second");
+
+        auto replacement = copy;
+        replacement += ".new";
+        std::filesystem::copy_file(copy, replacement, std::filesystem::copy_options::overwrite_existing);
+        std::ofstream{replacement, std::ios::app} << "[Replaced]\nKey=1\n";
+        std::filesystem::rename(replacement, copy);
+        auto const replaced = watcher.wait(std::chrono::seconds{5});
+        assert(replaced && replaced->added_sections == std::vector<std::string>{"Replaced"});
+        assert(replaced->modified_sections.empty() && replaced->removed_sections.empty());
+
+        assert(!watcher.wait(std::chrono::milliseconds{0}));
+        std::filesystem::remove(copy);
+    }
+
+    // every scanning kernel must find the same stops as the scalar one
+    {
+        std::string const line = "a long key with some spaces in it = and a value ; then a comment\n";
+        for (auto kernel : {tom::char_scanner::kernel::scalar,
+                            tom::char_scanner::kernel::sse2,
+                            tom::char_scanner::kernel::avx2}) {
+            tom::char_scanner const scanner{"#;\n=", kernel};
+            assert(scanner.find(line.data(), line.size()) == line.find('='));
+            assert(scanner.find(line.data() + 35, line.size() - 35) == line.find(';') - 35);
+            assert(scanner.skip_space("  \t\n  x", 7) == 6);
+        }
+
+        // a set too large for the vector kernels reports the scalar one it runs
+        tom::char_scanner const wide{"#;\n=[]:\"'"};
+        assert(wide.selected_kernel() == tom::char_scanner::kernel::scalar);
+        assert(wide.find(line.data(), line.size()) == line.find('='));
+    }
+
     // create new values
 
     f.add_section("IniParse Defined Section", nullptr);
@@ -63,12 +566,92 @@ int main(int argc, char const* argv[]) {
     f.get_section("SNMP")->remove_entry("UseSNMP");
     f.remove_section("SNMP");
 
+    // the key index follows entries and sections as they come and go
+    assert(f.get_entry("IniParse Defined Key 2")->value() == "Second INI Parse Value");
+    for (auto const& defining : f.sections_defining("UseSNMP"))
+        assert(defining->name != "SNMP");
+    for (auto const& defining : f.sections_defining("FTPPort"))
+        assert(defining->get_entry("FTPPort") != nullptr);
+
+    // a section moved out of its file takes its keys out of the file's index
+    {
+        auto              moving = tom::ini_parser::from_buffer("[s]\nk=v\n").parse();
+        tom::ini_section moved{std::move(*moving.get_section("s"))};
+        assert(moving.get_entry("k") == nullptr && moving.sections_defining("k").empty());
+        assert(moved.get_entry("k") != nullptr);
+    }
+
+    // assigning to an entry a section holds keeps its key, which the section
+    // and the file's index view, and takes the value
+    {
+        auto assigned = tom::ini_parser::from_buffer("[s]\nk=v\n").parse();
+        *assigned.get_entry("k") = tom::ini_entry{{ }, std::string{"other"}, std::string{"copied"}};
+        assert(assigned.get_entry("k")->key() == "k" && assigned.get_entry("k")->value() == "copied");
+        tom::ini_entry moved_in{{ }, std::string{"other"}, std::string{"moved"}};
+        *assigned.get_section("s")->get_entry("k") = std::move(moved_in);
+        assert(assigned.get_section("s")->get_value("k").first == "moved" && assigned.get_entry("other") == nullptr);
+
+        tom::ini_entry loose{{ }, std::string{"a"}, std::string{"1"}};
+        loose = *assigned.get_entry("k");
+        assert(loose.key() == "k");
+    }
+
+    // a section is in one file at a time, so each file's index stays whole
+    {
+        auto       first  = tom::ini_parser::from_buffer("[s]\nk=v\n").parse();
+        auto       second = tom::ini_parser::from_buffer("[t]\nj=w\n").parse();
+        auto const shared = first.get_section("s");
+        bool       threw  = false;
+        try {
+            second.add_section(shared);
+        } catch (std::invalid_argument const&) {
+            threw = true;
+        }
+        assert(threw && second.get_section("s") == nullptr && first.get_entry("k") != nullptr);
+
+        first.remove_section("s");
+        second.add_section(shared);
+        shared->add_entry("added", "1");
+        assert(second.get_entry("added") != nullptr && first.get_entry("added") == nullptr);
+    }
+
+    // the in place ranges see the same tree as the cached weak_ptr vectors
+    {
+        std::size_t section_count = 0;
+        for (auto const& each : f.each_section()) {
+            assert(each.each_entry().size() == each.entries().size());
+            section_count++;
+        }
+        assert(section_count == f.sections().size());
+    }
+
     // serialize
     std::ofstream stream{"test/output.ini"};
     if (stream.is_open()) {
         stream << f;
     }
 
+    // the writer matches operator<< and keeps the order entries were added in
+    {
+        auto const written = std::filesystem::temp_directory_path() / "parsetest_written.ini";
+        auto const read    = [&written] {
+            std::ifstream in{written};
+            return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{ }};
+        };
+        std::ostringstream expected{ };
+        expected << f;
+
+        tom::ini_writer::write_file(f, written.string(), {.order = tom::write_order::unordered});
+        assert(read() == expected.str());
+
+        tom::ini_writer::write_file(f, written.string(), {.order = tom::write_order::insertion, .buffer_size = 64});
+        auto const ordered = read();
+        assert(ordered.size() == expected.str().size());
+        assert(ordered.find("[IniParse Defined Section]\nIniParse Defined Key=First INI Parse Value\n"
+                            "IniParse Defined Key 2=Second INI Parse Value\n") != std::string::npos);
+        std::filesystem::remove(written);
+    }
+
     std::vector<std::weak_ptr<tom::ini_entry>> entries;
     // create a list
     {